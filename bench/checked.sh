@@ -0,0 +1,93 @@
+#!/bin/bash
+#
+# Overhead of checked arithmetic (-C) over plain long arithmetic, on the
+# recursion benchmarks and a few loop kernels.
+#
+
+N=${1:-300}
+CC=${CC:-cc}
+DIR=$(mktemp -d /tmp/checkedXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+echo "Hindi PL/0 checked arithmetic benchmark"
+echo "========================"
+
+# Matrix product: every subscript and product is in range of its loops.
+cat > "$DIR/matmul.hindi" <<HINDI
+नियत न = $N, वर्ग = $((N * N));
+चर क[वर्ग], ख[वर्ग], ग[वर्ग], i, j, k, योग, कुल;
+
+आरम्भ
+    प्रत्येक i := 0 तक वर्ग - 1 करो
+    आरम्भ
+        क[i] := i / न - i / 7 * 7;
+        ख[i] := i / 3 - i / न * 2
+    समापन;
+    प्रत्येक i := 0 तक न - 1 करो
+        प्रत्येक j := 0 तक न - 1 करो
+        आरम्भ
+            योग := 0;
+            प्रत्येक k := 0 तक न - 1 करो
+                योग := योग + क[i * न + k] * ख[k * न + j];
+            ग[i * न + j] := योग
+        समापन;
+    कुल := 0;
+    प्रत्येक i := 0 तक वर्ग - 1 करो
+        कुल := कुल + ग[i];
+    अंक_लिखें कुल
+समापन .
+HINDI
+
+# Collatz steps: values the compiler cannot bound, checked throughout.
+cat > "$DIR/collatz.hindi" <<HINDI
+चर क, ग, ज;
+
+आरम्भ
+    ग := 0;
+    प्रत्येक ज := 1 तक $((N * 5000)) करो
+    आरम्भ
+        क := ज;
+        जबतक क > 1 करो
+        आरम्भ
+            यदि विषम क तो क := 3 * क + 1;
+            यदि क > 1 तो क := क / 2;
+            ग := ग + 1
+        समापन
+    समापन;
+    अंक_लिखें ग
+समापन .
+HINDI
+
+for f in recursion/*.hindi; do
+	cp "$f" "$DIR/"
+done
+
+# Best of five runs.
+run() {
+	local i start end
+
+	secs=
+	for i in 1 2 3 4 5; do
+		start=$(date +%s.%N)
+		out=$("$1") || exit 1
+		end=$(date +%s.%N)
+		secs=$(awk -v s="$start" -v e="$end" -v b="$secs" \
+		    'BEGIN { t = e - s; print (b == "" || t < b) ? t : b }')
+	done
+}
+
+printf "%-18s %12s %8s %8s %8s\n" program result plain "-C" overhead
+for src in "$DIR"/*.hindi; do
+	f=$(basename "$src" .hindi)
+	./../hindipl0c "$src" > "$DIR/$f.c" || exit 1
+	./../hindipl0c -C "$src" > "$DIR/$f-C.c" || exit 1
+	$CC -O2 -w "$DIR/$f.c" -o "$DIR/$f" || exit 1
+	$CC -O2 -w "$DIR/$f-C.c" -o "$DIR/$f-C" || exit 1
+
+	run "$DIR/$f"
+	plain=$secs
+	run "$DIR/$f-C"
+	awk -v f="$f" -v o="$out" -v p="$plain" -v c="$secs" 'BEGIN {
+	    printf "%-18s %12s %8.3f %8.3f %+7.1f%%\n", f, o, p, c,
+	        (c - p) / p * 100 }'
+done
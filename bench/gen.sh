@@ -0,0 +1,181 @@
+#!/bin/bash
+#
+# Write a large, deterministic Hindi PL/0 program to stdout.
+#
+#	gen.sh kind n
+#
+# kind is one of:
+#	expr		statements of parenthesised expressions nested 64 deep
+#	procs		n procedures, each called once from the main body
+#	longid		assignments between identifiers 200 letters long
+#	comments	one short statement under every few lines of comment
+#	blank		statements spread out with runs of spaces and newlines
+#	devanagari	many distinct identifiers built from conjuncts and matras
+#	loop		one जबतक loop of n statements indexing by its counter
+#	count		the same in a प्रत्येक loop
+#
+# The same kind and n always give the same bytes.
+#
+
+usage() {
+	echo "usage: gen.sh expr|procs|longid|comments|blank|devanagari|loop|count n" >&2
+	exit 1
+}
+
+[ $# -eq 2 ] || usage
+KIND=$1
+N=$2
+case $N in
+''|*[!0-9]*)
+	usage
+	;;
+esac
+
+case $KIND in
+expr)
+	awk -v n="$N" 'BEGIN {
+		print "चर क, ख, ग;"
+		print "आरम्भ"
+		print "    क := 1; ख := 2;"
+		for (i = 0; i < n; i++) {
+			s = "क"
+			for (d = 0; d < 64; d++)
+				s = "(" s (d % 2 ? " * " : " + ") \
+				    (d % 3 ? "ख" : (i + d) % 97) ")"
+			print "    ग := " s " - ग;"
+		}
+		print "    अंक_लिखें ग"
+		print "समापन ."
+	}'
+	;;
+procs)
+	awk -v n="$N" 'BEGIN {
+		print "चर योग;"
+		for (i = 0; i < n; i++) {
+			print "प्रक्रिया काम_" i "(क, ख);"
+			print "चर ग;"
+			print "आरम्भ"
+			print "    ग := क * " i " + ख;"
+			print "    यदि ग > 1000 तो ग := ग / 7;"
+			print "    लौटाओ ग - क"
+			print "समापन;"
+		}
+		print "आरम्भ"
+		print "    योग := 0;"
+		for (i = 0; i < n; i++)
+			print "    योग := योग + काम_" i "(योग, " i ");"
+		print "    अंक_लिखें योग"
+		print "समापन ."
+	}'
+	;;
+longid)
+	awk -v n="$N" 'BEGIN {
+		split("क ख ग घ च छ ज झ ट ठ ड ढ त थ द ध न प फ ब", c, " ")
+		for (v = 0; v < 8; v++) {
+			id[v] = ""
+			for (j = 0; j < 200; j++)
+				id[v] = id[v] c[(j * (v + 3) + v) % 20 + 1]
+		}
+		printf "चर "
+		for (v = 0; v < 8; v++)
+			printf "%s%s", id[v], v < 7 ? ", " : ";\n"
+		print "आरम्भ"
+		for (i = 0; i < n; i++)
+			print "    " id[i % 8] " := " id[(i + 3) % 8] " + " \
+			    id[(i + 5) % 8] " - " i ";"
+		print "    अंक_लिखें " id[0]
+		print "समापन ."
+	}'
+	;;
+comments)
+	awk -v n="$N" 'BEGIN {
+		print "चर क;"
+		print "आरम्भ"
+		print "    क := 0;"
+		for (i = 0; i < n; i++) {
+			print "    { यह पंक्ति " i " की टिप्पणी है, जो कोड से"
+			print "      कहीं लम्बी है और केवल पढ़ी जाती है:"
+			print "      क := क + 1; जबतक क < 10 करो क := क * 2 }"
+			print "    क := क + " i % 10 ";"
+		}
+		print "    अंक_लिखें क"
+		print "समापन ."
+	}'
+	;;
+blank)
+	awk -v n="$N" 'BEGIN {
+		pad = sprintf("%64s", "")
+		print "चर क, ख;"
+		print "आरम्भ"
+		print "    क := 0;"
+		for (i = 0; i < n; i++) {
+			print pad "क" pad
+			print pad ":=" pad "\n\n\n"
+			print pad "क" pad "+" pad i % 10 pad ";" pad
+			print "\t\t\t\t\n"
+		}
+		print "    अंक_लिखें क"
+		print "समापन ."
+	}'
+	;;
+devanagari)
+	awk -v n="$N" 'BEGIN {
+		split("क्ष त्र ज्ञ श्र क ख ग घ च ज ट ड त द न प ब म य र ल व श स ह", c, " ")
+		split("ा ि ी ु ू े ै ो ौ ं", m, " ")
+		for (v = 0; v < 256; v++) {
+			id[v] = c[v % 25 + 1] m[int(v / 25) % 10 + 1] \
+			    c[(v * 7) % 25 + 1] "्" c[(v * 11) % 25 + 1] \
+			    m[(v * 3) % 10 + 1] c[(v * 13) % 25 + 1]
+			while (id[v] in seen)
+				id[v] = id[v] m[v % 10 + 1] c[v % 25 + 1]
+			seen[id[v]] = 1
+		}
+		for (v = 0; v < 256; v += 16) {
+			printf "%s", v ? "    " : "चर "
+			for (j = v; j < v + 16; j++)
+				printf "%s%s", id[j], j < 255 ? ", " : ";\n"
+			if (v < 240)
+				print ""
+		}
+		print "आरम्भ"
+		for (i = 0; i < n; i++)
+			print "    " id[i % 256] " := " id[(i * 5) % 256] \
+			    " * 3 + " id[(i * 7 + 1) % 256] ";"
+		print "    अंक_लिखें " id[0]
+		print "समापन ."
+	}'
+	;;
+loop)
+	awk -v n="$N" 'BEGIN {
+		print "चर अ[100], i, ग;"
+		print "आरम्भ"
+		print "    i := 0; ग := 0;"
+		print "    जबतक i < 100 करो"
+		print "    आरम्भ"
+		for (j = 0; j < n; j++)
+			print "        ग := ग + अ[i] * " j % 10 ";"
+		print "        i := i + 1"
+		print "    समापन;"
+		print "    अंक_लिखें ग"
+		print "समापन ."
+	}'
+	;;
+count)
+	awk -v n="$N" 'BEGIN {
+		print "चर अ[100], i, ग;"
+		print "आरम्भ"
+		print "    ग := 0;"
+		print "    प्रत्येक i := 0 तक 99 करो"
+		print "    आरम्भ"
+		for (j = 0; j < n; j++)
+			print "        ग := ग + अ[i] * " j % 10 ";"
+		print "        ग := ग + 1"
+		print "    समापन;"
+		print "    अंक_लिखें ग"
+		print "समापन ."
+	}'
+	;;
+*)
+	usage
+	;;
+esac
@@ -0,0 +1,56 @@
+#!/bin/bash
+#
+# Lexer throughput in MB/s for each scanner implementation, on sources
+# dominated by whitespace, comments and Devanagari identifiers.
+# Only the lexer stage (-t) runs, so parsing and output are not timed.
+#
+
+N=${1:-100000}
+DIR=$(mktemp -d /tmp/lexerXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+echo "Hindi PL/0 lexer throughput benchmark"
+echo "========================"
+
+awk -v n="$N" 'BEGIN {
+	print "चर क;"
+	print "आरम्भ"
+	for (i = 0; i < n; i++)
+		print "\t\t\t\t        क        :=        क        +        1        ;\n\n"
+	print "क := 0 समापन ."
+}' > "$DIR/whitespace.hindi"
+
+awk -v n="$N" 'BEGIN {
+	print "चर क;"
+	print "आरम्भ"
+	for (i = 0; i < n; i++) {
+		print "    { यह एक लंबी टिप्पणी है जो केवल पाठ को बढ़ाने के लिए"
+		print "      लिखी गई है; इसमें कोई कोड नहीं है " i " }"
+		print "    क := क + 1;"
+	}
+	print "क := 0 समापन ."
+}' > "$DIR/comment.hindi"
+
+awk -v n="$N" 'BEGIN {
+	print "चर अत्यधिक_लंबा_देवनागरी_चर_नाम_गणक, संख्याओं_का_संचित_योगफल;"
+	print "आरम्भ"
+	for (i = 0; i < n; i++)
+		print "संख्याओं_का_संचित_योगफल := संख्याओं_का_संचित_योगफल + अत्यधिक_लंबा_देवनागरी_चर_नाम_गणक;"
+	print "अत्यधिक_लंबा_देवनागरी_चर_नाम_गणक := 0 समापन ."
+}' > "$DIR/identifier.hindi"
+
+/usr/bin/printf "%-12s %-8s %10s %10s\n" "input" "scanner" "bytes" "MB/s"
+for f in whitespace comment identifier; do
+	bytes=$(wc -c < "$DIR/$f.hindi")
+	for impl in scalar sse2 avx2; do
+		start=$(date +%s.%N)
+		HINDIPL0_SCAN=$impl ./../hindipl0c -t "$DIR/$f.hindi" > /dev/null ||
+		    exit 1
+		end=$(date +%s.%N)
+		awk -v f="$f" -v i="$impl" -v b="$bytes" -v s="$start" \
+		    -v e="$end" 'BEGIN {
+			printf "%-12s %-8s %10d %10.1f\n", f, i, b,
+			    b / (e - s) / 1e6
+		}'
+	done
+done
@@ -0,0 +1,88 @@
+#!/bin/bash
+#
+# Run time with and without --memo: a loop calling pure procedures with
+# few distinct inputs, the same loop with no input repeated, and the
+# recursion benchmarks.  The hit rate is over all memoized calls.
+#
+
+N=${1:-1000000}
+CC=${CC:-cc}
+DIR=$(mktemp -d /tmp/memoXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+echo "Hindi PL/0 memoization benchmark"
+echo "========================"
+
+# A cost that depends on its argument and on globals, asked again and again.
+cat > "$DIR/repeat.hindi" <<HINDI
+चर आधार, वृद्धि, i, कुल;
+
+प्रक्रिया चरण(x);
+चर न;
+आरम्भ
+    न := 0;
+    जबतक x > 1 करो
+    आरम्भ
+        यदि विषम x तो x := 3 * x + वृद्धि;
+        यदि x > 1 तो x := x / 2;
+        न := न + 1
+    समापन;
+    लौटाओ न + आधार
+समापन;
+
+आरम्भ
+    आधार := 1;
+    वृद्धि := 1;
+    कुल := 0;
+    i := 0;
+    जबतक i < $N करो
+    आरम्भ
+        कुल := कुल + चरण(i - i / 97 * 97 + 100000);
+        i := i + 1
+    समापन;
+    अंक_लिखें कुल
+समापन .
+HINDI
+
+# The same with every input new: the cost of a miss.
+sed 's|चरण(i - i / 97 \* 97 + 100000)|चरण(i + 100000)|' \
+    "$DIR/repeat.hindi" > "$DIR/distinct.hindi"
+
+for f in recursion/*.hindi; do
+	cp "$f" "$DIR/"
+done
+
+# Best of five runs; the memoized ones' reports go to $DIR/report.
+run() {
+	local i start end
+
+	secs=
+	for i in 1 2 3 4 5; do
+		start=$(date +%s.%N)
+		out=$("$1" 2> "$DIR/report") || exit 1
+		end=$(date +%s.%N)
+		secs=$(awk -v s="$start" -v e="$end" -v b="$secs" \
+		    'BEGIN { t = e - s; print (b == "" || t < b) ? t : b }')
+	done
+}
+
+printf "%-18s %12s %8s %8s %8s %8s\n" program result plain memo change \
+    "hit %"
+for src in "$DIR"/*.hindi; do
+	f=$(basename "$src" .hindi)
+	./../hindipl0c "$src" > "$DIR/$f.c" || exit 1
+	./../hindipl0c --memo "$src" > "$DIR/$f-memo.c" || exit 1
+	$CC -O2 -w "$DIR/$f.c" -o "$DIR/$f" || exit 1
+	$CC -O2 -w "$DIR/$f-memo.c" -o "$DIR/$f-memo" || exit 1
+
+	run "$DIR/$f"
+	plain=$secs
+	run "$DIR/$f-memo"
+	hits=$(awk '$1 == "memo" { c += $2; h += $3 }
+	    END { if (c) printf "%.1f", h * 100 / c; else print "-" }' \
+	    "$DIR/report")
+	awk -v f="$f" -v o="$out" -v p="$plain" -v m="$secs" -v h="$hits" \
+	    'BEGIN {
+	    printf "%-18s %12s %8.3f %8.3f %+7.1f%% %8s\n", f, o, p, m,
+	        (m - p) / p * 100, h }'
+done
@@ -0,0 +1,54 @@
+#!/bin/bash
+#
+# Scaling of a समानांतर loop with HINDIPL0_THREADS = 1, 2, 4, 8 and 16.
+#
+
+N=${1:-2000}
+CC=${CC:-cc}
+DIR=$(mktemp -d /tmp/parallelXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+echo "Hindi PL/0 parallel loop benchmark"
+echo "========================"
+
+# Each iteration counts the Collatz steps of a few numbers.
+cat > "$DIR/par.hindi" <<HINDI
+नियत न = $N;
+चर चरण[न], i, कुल, क, ग, ज;
+
+आरम्भ
+    समानांतर i := 0 तक न - 1 करो
+    आरम्भ
+        ग := 0;
+        क := 0;
+        ज := 1;
+        जबतक ज < 200 करो
+        आरम्भ
+            क := i * 200 + ज;
+            जबतक क > 1 करो
+            आरम्भ
+                यदि विषम क तो क := 3 * क + 1;
+                यदि क > 1 तो क := क / 2;
+                ग := ग + 1
+            समापन;
+            ज := ज + 1
+        समापन;
+        चरण[i] := ग
+    समापन;
+    कुल := 0;
+    समानांतर i := 0 तक न - 1 संचय कुल करो
+        कुल := कुल + चरण[i];
+    अंक_लिखें कुल
+समापन .
+HINDI
+
+./../hindipl0c "$DIR/par.hindi" > "$DIR/par.c" || exit 1
+$CC -O2 -w -pthread "$DIR/par.c" -o "$DIR/par" || exit 1
+
+for t in 1 2 4 8 16; do
+	start=$(date +%s.%N)
+	out=$(HINDIPL0_THREADS=$t "$DIR/par") || exit 1
+	end=$(date +%s.%N)
+	awk -v t="$t" -v o="$out" -v s="$start" -v e="$end" '
+	    BEGIN { printf "%2d threads %12s %8.3f s\n", t, o, e - s }'
+done | awk '{ if (NR == 1) base = $4; printf "%s  x%.2f\n", $0, base / $4 }'
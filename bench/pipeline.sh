@@ -0,0 +1,36 @@
+#!/bin/bash
+#
+# Compare the synchronous front end with the pipelined one (-P) on a
+# multi-MB generated source.
+#
+
+N=${1:-50000}
+SRC=$(mktemp /tmp/pipelineXXXXXX.hindi)
+trap 'rm -f "$SRC"' EXIT
+
+echo "Hindi PL/0 pipelined front end benchmark"
+echo "========================"
+
+awk -v n="$N" 'BEGIN {
+	print "चर गणक, योगफल, अस्थायी_मान;"
+	print "आरम्भ"
+	print "    गणक := 0;"
+	for (i = 0; i < n; i++) {
+		print "    { पंक्ति " i " }"
+		print "    योगफल := (योगफल + गणक * " i ") / (अस्थायी_मान + 1);"
+	}
+	print "    अस्थायी_मान := योगफल"
+	print "समापन ."
+}' > "$SRC"
+
+/usr/bin/printf "input: %s bytes, %s statements\n" "$(wc -c < "$SRC")" "$N"
+
+for mode in sync -P; do
+	flag=$mode
+	[ "$mode" == "sync" ] && flag=
+	start=$(date +%s.%N)
+	./../hindipl0c $flag "$SRC" > /dev/null || exit 1
+	end=$(date +%s.%N)
+	awk -v m="$mode" -v s="$start" -v e="$end" \
+	    'BEGIN { printf "%-6s %8.3f s\n", m, e - s }'
+done
@@ -0,0 +1,23 @@
+#!/bin/bash
+#
+# Time recursive programs written with parameters and लौटाओ against the
+# same algorithms passing arguments and results through global variables.
+#
+
+CC=${CC:-cc}
+DIR=$(mktemp -d /tmp/recursionXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+echo "Hindi PL/0 recursion benchmark"
+echo "========================"
+
+for f in fib fib_global ackermann ackermann_global tree tree_global; do
+	./../hindipl0c "recursion/$f.hindi" > "$DIR/$f.c" || exit 1
+	$CC -O2 -w "$DIR/$f.c" -o "$DIR/$f" || exit 1
+
+	start=$(date +%s.%N)
+	out=$("$DIR/$f") || exit 1
+	end=$(date +%s.%N)
+	awk -v f="$f" -v o="$out" -v s="$start" -v e="$end" \
+	    'BEGIN { printf "%-18s %12s %8.3f s\n", f, o, e - s }'
+done
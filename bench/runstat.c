@@ -0,0 +1,116 @@
+/*
+ * Run a program and report on stderr, as one line, its wall time in
+ * seconds, its peak RSS in KiB and the user-space instructions it
+ * retired, or "-" where the kernel does not let us count them.
+ *
+ *	runstat program [argument ...]
+ */
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/*
+ * A counter of the instructions pid retires in user space once it calls
+ * exec, or -1.
+ */
+static int
+counter(pid_t pid)
+{
+#ifdef __linux__
+	struct perf_event_attr pe;
+
+	memset(&pe, 0, sizeof(pe));
+	pe.type = PERF_TYPE_HARDWARE;
+	pe.size = sizeof(pe);
+	pe.config = PERF_COUNT_HW_INSTRUCTIONS;
+	pe.disabled = 1;
+	pe.enable_on_exec = 1;
+	pe.inherit = 1;
+	pe.exclude_kernel = 1;
+	pe.exclude_hv = 1;
+	return (int) syscall(SYS_perf_event_open, &pe, pid, -1, -1, 0);
+#else
+	(void) pid;
+	return -1;
+#endif
+}
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct rusage ru;
+	long long count;
+	double start;
+	pid_t pid;
+	int fd, go[2], status;
+	char c;
+
+	if (argc < 2) {
+		(void) fputs("usage: runstat program [argument ...]\n", stderr);
+		return 1;
+	}
+
+	/* The child waits on go[0] until its counter is open. */
+	if (pipe(go) == -1) {
+		perror("pipe");
+		return 1;
+	}
+	start = now();
+	if ((pid = fork()) == -1) {
+		perror("fork");
+		return 1;
+	}
+	if (pid == 0) {
+		(void) close(go[1]);
+		if (read(go[0], &c, 1) != 1)
+			_exit(127);
+		(void) close(go[0]);
+		execvp(argv[1], &argv[1]);
+		(void) fprintf(stderr, "runstat: %s: %s\n", argv[1],
+		    strerror(errno));
+		_exit(127);
+	}
+	(void) close(go[0]);
+	fd = counter(pid);
+	if (write(go[1], "", 1) != 1) {
+		perror("write");
+		return 1;
+	}
+	(void) close(go[1]);
+
+	if (wait4(pid, &status, 0, &ru) == -1) {
+		perror("wait4");
+		return 1;
+	}
+	(void) fprintf(stderr, "%.6f %ld ", now() - start, ru.ru_maxrss);
+	if (fd != -1 && read(fd, &count, sizeof(count)) == sizeof(count))
+		(void) fprintf(stderr, "%lld\n", count);
+	else
+		(void) fputs("-\n", stderr);
+
+	if (WIFEXITED(status))
+		return WEXITSTATUS(status);
+	return 128 + WTERMSIG(status);
+}
@@ -0,0 +1,143 @@
+#!/bin/bash
+#
+# Run time of the programs in runtime/, compiled by every C compiler found
+# (or those in CCS), plain and with -C, at each of OPTS.  Every output is
+# checked against runtime/outputs, and every program against
+# runtime.baseline.  The run fails on a wrong output or on a regression.
+# Where the kernel lets us count instructions, a regression is more than
+# INSN_THRESHOLD percent (default 3) more instructions.  Otherwise it is
+# more than THRESHOLD percent (default 25) more time.  -u writes this run
+# as the new baseline instead.
+#
+
+THRESHOLD=${THRESHOLD:-25}
+INSN_THRESHOLD=${INSN_THRESHOLD:-3}
+OPTS=${OPTS:-"-O0 -O1 -O2 -O3"}
+BASELINE=runtime.baseline
+PROGS="sieve collatz gcd matrix print"
+DIR=$(mktemp -d /tmp/runtimeXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+update=0
+if [ "$1" == "-u" ]; then
+	update=1
+elif [ $# -ne 0 ]; then
+	echo "usage: runtime.sh [-u]" >&2
+	exit 1
+fi
+
+if [ -z "$CCS" ]; then
+	for c in gcc clang tcc; do
+		command -v $c > /dev/null && CCS="$CCS $c"
+	done
+	CCS=${CCS:-cc}
+fi
+
+echo "Hindi PL/0 generated code benchmark"
+echo "========================"
+
+set -- $CCS
+$1 -O2 -o "$DIR/runstat" runstat.c || exit 1
+
+# Median of five runs: sets secs, kib and instrs, and checks the output.
+run() {
+	local i
+
+	for i in 1 2 3 4 5; do
+		"$DIR/runstat" "$1" > "$DIR/out" 2> "$DIR/stat" || {
+			echo "$1 failed:" >&2
+			cat "$DIR/stat" >&2
+			exit 1
+		}
+		tail -n 1 "$DIR/stat"
+	done > "$DIR/runs"
+	read -r secs kib instrs <<< "$(sort -g "$DIR/runs" | sed -n 3p)"
+	got=$(cksum < "$DIR/out")
+	want=$(awk -v p="$2" '$1 == p { print $2, $3 }' runtime/outputs)
+	if [ "$got" != "$want" ]; then
+		echo "WRONG OUTPUT: $2 $3 $4 $5: cksum $got, expected $want"
+		bad=1
+	fi
+}
+
+bad=0
+: > "$DIR/times"
+printf "%-8s %-6s %-5s %-4s %8s %8s %8s %14s %9s\n" program cc mode opt \
+    seconds baseline change instructions "max KiB"
+for p in $PROGS; do
+	for mode in plain -C; do
+		flag=$mode
+		[ "$mode" == "plain" ] && flag=
+		./../hindipl0c $flag "runtime/$p.hindi" > "$DIR/$p.c" || exit 1
+		for cc in $CCS; do
+			for opt in $OPTS; do
+				$cc $opt -w -pthread "$DIR/$p.c" -o "$DIR/$p" ||
+				    exit 1
+				run "$DIR/$p" "$p" "$cc" "$mode" "$opt"
+				base=$(awk -v k="$p $cc $mode $opt" \
+				    '$1 " " $2 " " $3 " " $4 == k { print $5 }' \
+				    "$BASELINE" 2> /dev/null)
+				awk -v p="$p" -v c="$cc" -v m="$mode" \
+				    -v o="$opt" -v s="$secs" -v b="$base" \
+				    -v i="$instrs" -v k="$kib" 'BEGIN {
+					if (b == "")
+						printf "%-8s %-6s %-5s %-4s %8.3f " \
+						    "%8s %8s", p, c, m, o, s, "-", "-"
+					else
+						printf "%-8s %-6s %-5s %-4s %8.3f " \
+						    "%8.3f %+7.1f%%", p, c, m, o, s,
+						    b, (s - b) / b * 100
+					printf " %14s %9d\n", i, k
+				}'
+				echo "$p $cc $mode $opt $secs $instrs" \
+				    >> "$DIR/times"
+			done
+		done
+	done
+done
+
+[ $bad -eq 0 ] || exit 1
+
+if [ $update -eq 1 ]; then
+	cp "$DIR/times" "$BASELINE"
+	echo "baseline written to bench/$BASELINE"
+	exit 0
+fi
+
+if [ ! -f "$BASELINE" ]; then
+	echo "no bench/$BASELINE; run ./runtime.sh -u to make one"
+	exit 0
+fi
+
+awk -v t="$THRESHOLD" -v it="$INSN_THRESHOLD" '
+	NR == FNR {
+		base[$1 " " $2 " " $3 " " $4] = $5
+		insns[$1 " " $2 " " $3 " " $4] = $6
+		next
+	}
+	!(($1 " " $2 " " $3 " " $4) in base) {
+		next
+	}
+	{
+		b = base[$1 " " $2 " " $3 " " $4]
+		i = insns[$1 " " $2 " " $3 " " $4]
+	}
+	$6 != "-" && i != "-" && i != "" {
+		if ($6 > i * (1 + it / 100)) {
+			printf "SLOWER: %s %s %s %s: %d instructions, " \
+			    "baseline %d (%+.1f%%)\n", $1, $2, $3, $4, $6, i,
+			    ($6 - i) / i * 100
+			bad = 1
+		}
+		next
+	}
+	$5 > b * (1 + t / 100) + 0.005 {
+		printf "SLOWER: %s %s %s %s: %.3f s, baseline %.3f s " \
+		    "(%+.1f%%)\n", $1, $2, $3, $4, $5, b, ($5 - b) / b * 100
+		bad = 1
+	}
+	END {
+		if (bad)
+			exit 1
+		print "all programs within the baseline"
+	}' "$BASELINE" "$DIR/times"
@@ -0,0 +1,35 @@
+#!/bin/bash
+#
+# Time each way into the code generator on a multi-MB generated source:
+# from source, from a cached token stream and from cached IR.
+#
+
+N=${1:-50000}
+DIR=$(mktemp -d /tmp/stagesXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+echo "Hindi PL/0 staged compilation benchmark"
+echo "========================"
+
+awk -v n="$N" 'BEGIN {
+	print "चर गणक, योगफल, अस्थायी_मान;"
+	print "आरम्भ"
+	print "    गणक := 0;"
+	for (i = 0; i < n; i++) {
+		print "    { पंक्ति " i " }"
+		print "    योगफल := (योगफल + गणक * " i ") / (अस्थायी_मान + 1);"
+	}
+	print "    अस्थायी_मान := योगफल"
+	print "समापन ."
+}' > "$DIR/big.hindi"
+
+./../hindipl0c -t "$DIR/big.hindi" > "$DIR/big.tok" || exit 1
+./../hindipl0c -i "$DIR/big.tok" > "$DIR/big.ir" || exit 1
+
+for f in big.hindi big.tok big.ir; do
+	start=$(date +%s.%N)
+	./../hindipl0c "$DIR/$f" > /dev/null || exit 1
+	end=$(date +%s.%N)
+	awk -v f="$f" -v b="$(wc -c < "$DIR/$f")" -v s="$start" -v e="$end" \
+	    'BEGIN { printf "%-10s %10d bytes %8.3f s\n", f, b, e - s }'
+done
@@ -0,0 +1,57 @@
+#!/bin/bash
+#
+# Exec-to-exit latency of a short-lived program, built from the usual C
+# output (dynamic and static) and from --freestanding output, with the
+# size of each binary.  Each time is the median of N runs (default 200).
+#
+
+N=${1:-200}
+CC=${CC:-cc}
+DIR=$(mktemp -d /tmp/startupXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+echo "Hindi PL/0 startup benchmark"
+echo "========================"
+
+# A job that does almost nothing: a little arithmetic and some output.
+cat > "$DIR/job.hindi" <<HINDI
+चर क, ख, रिक्त;
+
+आरम्भ
+    रिक्त := 32;
+    ख := 0;
+    क := 1;
+    जबतक क < 11 करो
+    आरम्भ
+        ख := ख + क * क;
+        अंक_लिखें ख;
+        वर्ण_लिखें रिक्त;
+        क := क + 1
+    समापन;
+    वर्ण_लिखें 10
+समापन .
+HINDI
+
+$CC -O2 -o "$DIR/runstat" runstat.c || exit 1
+./../hindipl0c "$DIR/job.hindi" > "$DIR/hosted.c" || exit 1
+./../hindipl0c --freestanding "$DIR/job.hindi" > "$DIR/free.c" || exit 1
+$CC -O2 -w "$DIR/hosted.c" -o "$DIR/dynamic" || exit 1
+$CC -O2 -w -static "$DIR/hosted.c" -o "$DIR/static" ||
+    echo "no static C library; skipping the static build"
+$CC -O2 -w -static -nostdlib "$DIR/free.c" -o "$DIR/freestanding" || exit 1
+
+printf "%-13s %10s %10s %10s %14s\n" build bytes "median us" "min us" \
+    instructions
+for b in dynamic static freestanding; do
+	[ -x "$DIR/$b" ] || continue
+	for ((i = 0; i < N; i++)); do
+		"$DIR/runstat" "$DIR/$b" 2>&1 > /dev/null | tail -n 1
+	done > "$DIR/runs"
+	sort -g "$DIR/runs" | awk -v b="$b" -v s="$(wc -c < "$DIR/$b")" '
+		{ t[NR] = $1; i[NR] = $3 }
+		END {
+			m = int((NR + 1) / 2)
+			printf "%-13s %10d %10.0f %10.0f %14s\n", b, s,
+			    t[m] * 1e6, t[1] * 1e6, i[m]
+		}'
+done
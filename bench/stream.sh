@@ -0,0 +1,33 @@
+#!/bin/bash
+#
+# Compile ever larger generated programs from a pipe, never written to
+# disk, and print the time and peak RSS of each.  The RSS should stay
+# flat while the input grows: only the symbol table grows with it, not
+# even the output held back for one long loop body.
+#
+#	stream.sh [n]	programs of n, 4n and 16n statements (default 20000)
+#
+
+N=${1:-20000}
+
+echo "Hindi PL/0 streaming input benchmark"
+echo "========================"
+
+printf "%-10s %8s %10s %10s %10s\n" kind n "input MB" "wall ms" "peak KiB"
+for kind in expr comments devanagari loop count; do
+	for m in 1 4 16; do
+		n=$((N * m))
+		bytes=$(./gen.sh $kind $n | wc -c)
+		./gen.sh $kind $n |
+		    ./../hindipl0c --time-report=json - 2>&1 > /dev/null |
+		    awk -v k="$kind" -v n="$n" -v b="$bytes" '
+			/"total"/ {
+				match($0, /"total":\{"wall_ms":[0-9.]+/)
+				w = substr($0, RSTART + 19, RLENGTH - 19)
+				match($0, /"peak_rss_kib":[0-9]+/)
+				r = substr($0, RSTART + 15, RLENGTH - 15)
+				printf "%-10s %8d %10.1f %10.0f %10d\n", k, n,
+				    b / 1e6, w, r
+			}'
+	done
+done
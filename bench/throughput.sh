@@ -0,0 +1,96 @@
+#!/bin/bash
+#
+# Compiler throughput on the programs written by gen.sh, each at one, two
+# and four times its base size.  Reports lines and megabytes compiled per
+# second, peak RSS, and how far the time grows past linear in the size.
+#
+# Every time is compared with throughput.baseline, and the run fails if
+# any is more than THRESHOLD percent (default 25) slower.  -u writes the
+# times of this run as the new baseline instead.
+#
+
+THRESHOLD=${THRESHOLD:-25}
+BASELINE=throughput.baseline
+DIR=$(mktemp -d /tmp/throughputXXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+update=0
+if [ "$1" == "-u" ]; then
+	update=1
+elif [ $# -ne 0 ]; then
+	echo "usage: throughput.sh [-u]" >&2
+	exit 1
+fi
+
+# Base sizes, chosen for about 1 MB of source each.
+CASES="expr:2000 procs:1000 longid:500 comments:4000 blank:2000 devanagari:10000"
+
+echo "Hindi PL/0 compiler throughput benchmark"
+echo "========================"
+
+# Median of five runs, in seconds, after one to warm the caches.
+run() {
+	local i start end
+
+	./../hindipl0c "$1" > /dev/null || exit 1
+	for i in 1 2 3 4 5; do
+		start=$(date +%s.%N)
+		./../hindipl0c "$1" > /dev/null || exit 1
+		end=$(date +%s.%N)
+		awk -v s="$start" -v e="$end" 'BEGIN { print e - s }'
+	done > "$DIR/runs"
+	secs=$(sort -g "$DIR/runs" | sed -n 3p)
+}
+
+printf "%-11s %6s %9s %8s %8s %10s %8s %9s %6s\n" case n bytes lines \
+    seconds lines/s MB/s "peak KiB" scale
+: > "$DIR/times"
+for c in $CASES; do
+	kind=${c%:*}
+	for k in 1 2 4; do
+		n=$((${c#*:} * k))
+		src="$DIR/$kind-$n.hindi"
+		./gen.sh "$kind" "$n" > "$src" || exit 1
+		bytes=$(wc -c < "$src")
+		lines=$(wc -l < "$src")
+		run "$src"
+		[ $k -eq 1 ] && first=$secs
+		rss=$(./../hindipl0c --time-report=json "$src" 2>&1 > /dev/null |
+		    sed -n 's/.*"peak_rss_kib":\([0-9]*\).*/\1/p')
+		awk -v c="$kind" -v n="$n" -v b="$bytes" -v l="$lines" \
+		    -v s="$secs" -v r="$rss" -v f="$first" -v k="$k" 'BEGIN {
+			printf "%-11s %6d %9d %8d %8.3f %10.0f %8.2f %9d %6.2f\n",
+			    c, n, b, l, s, l / s, b / s / 1e6, r, s / f / k
+		}'
+		echo "$kind $n $secs" >> "$DIR/times"
+	done
+done
+
+if [ $update -eq 1 ]; then
+	cp "$DIR/times" "$BASELINE"
+	echo "baseline written to bench/$BASELINE"
+	exit 0
+fi
+
+if [ ! -f "$BASELINE" ]; then
+	echo "no bench/$BASELINE; run ./throughput.sh -u to make one"
+	exit 0
+fi
+
+# A few milliseconds of slack keeps the smallest cases from failing on
+# scheduling noise alone.
+awk -v t="$THRESHOLD" '
+	NR == FNR { base[$1 " " $2] = $3; next }
+	($1 " " $2) in base {
+		b = base[$1 " " $2]
+		if ($3 > b * (1 + t / 100) + 0.005) {
+			printf "SLOWER: %s %s: %.3f s, baseline %.3f s (%+.1f%%)\n",
+			    $1, $2, $3, b, ($3 - b) / b * 100
+			bad = 1
+		}
+	}
+	END {
+		if (bad)
+			exit 1
+		printf "all cases within %d%% of the baseline\n", t
+	}' "$BASELINE" "$DIR/times"
@@ -6,24 +6,36 @@
 
 int no_ident = 0;
 
-char* strdup_portable(const char* s) {
-    char* dup = malloc(strlen(s) + 1);
-    if (dup) strcpy(dup, s);
-    return dup;
-}
+#define ARENA_CHUNK 65536
 
-wchar_t* wcsdup_portable(const wchar_t* s) {
-    size_t len = wcslen(s) + 1;
-    wchar_t* dup = malloc(len * sizeof(wchar_t));
-    if (dup) wcscpy(dup, s);
-    return dup;
+static void* arena_alloc(HashMap* map, size_t n) {
+    ArenaChunk* chunk = map->arena;
+    n = (n + 15) & ~(size_t) 15;
+    if (chunk == NULL || chunk->size - chunk->used < n) {
+        size_t size = n > ARENA_CHUNK ? n : ARENA_CHUNK;
+        chunk = malloc(sizeof(ArenaChunk) + size);
+        if (chunk == NULL) {
+            fputs("[ERROR] malloc failed\n", stderr);
+            exit(1);
+        }
+        chunk->next = map->arena;
+        chunk->used = 0;
+        chunk->size = size;
+        map->arena = chunk;
+    }
+    void* p = chunk->data + chunk->used;
+    chunk->used += n;
+    return p;
 }
 
 unsigned long hash_wchar(const wchar_t* str) {
+    return hash_span(str, wcslen(str));
+}
+
+unsigned long hash_span(const wchar_t* str, size_t len) {
     unsigned long hash = 5381;
-    int c;
-    while ((c = *str++)) {
-        hash = ((hash << 5) + hash) + c;
+    while (len--) {
+        hash = ((hash << 5) + hash) + *str++;
     }
     return hash;
 }
@@ -32,6 +44,8 @@ HashMap* create_hashmap(int size) {
     HashMap* map = malloc(sizeof(HashMap));
     map->size = size;
     map->buckets = calloc(size, sizeof(HashNode*));
+    map->count = 0;
+    map->arena = NULL;
     return map;
 }
 
@@ -46,41 +60,46 @@ char* get(HashMap* map, const wchar_t* key) {
     return NULL;
 }
 
-void insert(HashMap* map, const wchar_t* key) {
-    unsigned long hash = hash_wchar(key);
+HashNode* insert(HashMap* map, const wchar_t* key) {
+    return insert_span(map, key, wcslen(key));
+}
+
+/*
+ * Intern key[0..len), which need not be terminated.  The key is only
+ * copied the first time it is seen.
+ */
+HashNode* insert_span(HashMap* map, const wchar_t* key, size_t len) {
+    unsigned long hash = hash_span(key, len);
     int index = hash % map->size;
 
     char value[50];
-    if(get(map,key) != NULL) return;
-    sprintf(value, "_var%d", no_ident++);
-    
     HashNode* node = map->buckets[index];
     while (node) {
-        if (wcscmp(node->key, key) == 0) {
-            free(node->value);
-            node->value = strdup_portable(value);
-            return;
-        }
+        if (wcsncmp(node->key, key, len) == 0 && node->key[len] == L'\0')
+            return node;
         node = node->next;
     }
+    int n = sprintf(value, "_var%d", no_ident++);
 
-    HashNode* new_node = malloc(sizeof(HashNode));
-    new_node->key = wcsdup_portable(key);
-    new_node->value = strdup_portable(value);
+    HashNode* new_node = arena_alloc(map, sizeof(HashNode));
+    new_node->key = arena_alloc(map, (len + 1) * sizeof(wchar_t));
+    wmemcpy(new_node->key, key, len);
+    new_node->key[len] = L'\0';
+    new_node->value = arena_alloc(map, n + 1);
+    memcpy(new_node->value, value, n + 1);
+    new_node->index = -1;
     new_node->next = map->buckets[index];
     map->buckets[index] = new_node;
+    map->count++;
+    return new_node;
 }
 
 void free_hashmap(HashMap* map) {
-    for (int i = 0; i < map->size; i++) {
-        HashNode* node = map->buckets[i];
-        while (node) {
-            HashNode* temp = node;
-            node = node->next;
-            free(temp->key);
-            free(temp->value);
-            free(temp);
-        }
+    ArenaChunk* chunk = map->arena;
+    while (chunk) {
+        ArenaChunk* temp = chunk;
+        chunk = chunk->next;
+        free(temp);
     }
     free(map->buckets);
     free(map);
@@ -6,20 +6,33 @@
 typedef struct HashNode {
   wchar_t *key;
   char *value;
+  int index;
   struct HashNode *next;
 } HashNode;
 
+/* Keys, C names and nodes are carved out of chunks freed together. */
+typedef struct ArenaChunk {
+  struct ArenaChunk *next;
+  size_t used;
+  size_t size;
+  char data[];
+} ArenaChunk;
+
 typedef struct HashMap {
   HashNode **buckets;
   int size;
+  int count;
+  ArenaChunk *arena;
 } HashMap;
 
 extern int no_ident;
 
 HashMap *create_hashmap(int size);
-void insert(HashMap *map, const wchar_t *key);
+HashNode *insert(HashMap *map, const wchar_t *key);
+HashNode *insert_span(HashMap *map, const wchar_t *key, size_t len);
 char *get(HashMap *map, const wchar_t *key);
 void free_hashmap(HashMap *map);
 unsigned long hash_wchar(const wchar_t *str);
+unsigned long hash_span(const wchar_t *str, size_t len);
 
 #endif
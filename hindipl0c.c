@@ -1,6 +1,9 @@
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/stat.h>
 #include <ctype.h>
 #include <fcntl.h>
+#include <getopt.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -12,16 +15,30 @@
 #include <wchar.h>
 #include <wctype.h>
 #include <locale.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
 #include "hashmap/hashmap.c"
+#include "scan/scan.c"
 
 #define CHECK_LHS	0
 #define CHECK_RHS	1
 #define CHECK_CALL	2
+#define CHECK_ANY	3
 #define TOK_WRITEINT 'w'
 #define TOK_WRITECHAR 'H'
 #define TOK_READINT 'R'
 #define TOK_READCHAR 'h'
 #define TOK_INTO 'n'
+#define TOK_RETURN 'r'
+#define TOK_PARALLEL 'p'
+#define TOK_TO 't'
+#define TOK_REDUCE 'a'
+#define TOK_SPAWN 's'
+#define TOK_WAIT 'j'
+#define TOK_FOR 'f'
+#define TOK_STEP 'k'
 
 #define PL0C_VERSION "1.0.0" 
 #define TOK_IDENT	'I'
@@ -51,17 +68,211 @@
 #define TOK_DIVIDE	'/'
 #define TOK_LPAREN	'('
 #define TOK_RPAREN	')'
+#define TOK_LBRACK	'['
+#define TOK_RBRACK	']'
+#define TOK_ERROR	'!'
+
+/* Intermediate file kinds and format version. */
+#define KIND_TOKENS	'T'
+#define KIND_IR		'I'
+#define INTER_VERSION	3
+
+/* Code generator operations recorded in the IR. */
+#define CG_INIT		1
+#define CG_END		2
+#define CG_CONST	3
+#define CG_SEMICOLON	4
+#define CG_SYMBOL	5
+#define CG_CRLF		6
+#define CG_VAR		7
+#define CG_PROCEDURE	8
+#define CG_EPILOGUE	9
+#define CG_READCHAR	10
+#define CG_CALL		11
+#define CG_ODD		12
+#define CG_WRITECHAR	13
+#define CG_READINT	14
+#define CG_WRITEINT	15
+#define CG_INDEX	16
+#define CG_ENDINDEX	17
+#define CG_CLOSE	18
+#define CG_DIM		19
+#define CG_MAIN		20
+#define CG_PROTOTYPE	21
+#define CG_ENDPROTO	22
+#define CG_PARAM	23
+#define CG_ENDHEADER	24
+#define CG_ENDCALL	25
+#define CG_SLOT		26
+#define CG_LIFT		27
+#define CG_TAIL		28
+#define CG_NUMBER	29
+#define CG_RETURN	30
+#define CG_TEMP		31
+#define CG_ENDTEMPS	32
+#define CG_REASSIGN	33
+#define CG_GOTO		34
+#define CG_USETEMPS	35
+#define CG_ENDSELF	36
+#define CG_PARBEGIN	37
+#define CG_PARTO	38
+#define CG_PARBODY	39
+#define CG_PARLOOP	40
+#define CG_PAREND	41
+#define CG_PARDECL	42
+#define CG_PARREDUCE	43
+#define CG_PARLAST	44
+#define CG_PARUNDEF	45
+#define CG_ENDDIVERT	46
+#define CG_PARCTX	47
+#define CG_CTXARG	48
+#define CG_PARRUN	49
+#define CG_OUTLINED	50
+#define CG_SPAWN	51
+#define CG_TASKARG	52
+#define CG_ENDSPAWN	53
+#define CG_WAIT		54
+#define CG_JOIN		55
+#define CG_GROUP	56
+#define CG_TASKS	57
+#define CG_THUNK	58
+#define CG_ENDTHUNK	59
+#define CG_FORBEGIN	60
+#define CG_FORTO	61
+#define CG_FORBODY	62
+#define CG_ENDFOR	63
+#define CG_CHECKBEGIN	64
+#define CG_CHECKOP	65
+#define CG_CHECKLINE	66
+#define CG_CHECKEND	67
+#define CG_CSECOPY	68
+#define CG_CSEHOIST	69
+#define CG_CSEUSE	70
+#define CG_CSETEMP	71
+#define CG_TYPE		72
+#define CG_CAST		73
+#define CG_CONDEND	74
+#define CG_FOLD		75
+#define CG_MEMO		76
+#define CG_MEMOVAR	77
+#define CG_FORKEEP	78
+
+/* How a lifted variable is spelled in a slot; LIFT_COMMA goes first. */
+#define LIFT_PROTO	1
+#define LIFT_PARAM	2
+#define LIFT_ADDR	3
+#define LIFT_ARG	4
+#define LIFT_DEFINE	5
+#define LIFT_UNDEF	6
+#define LIFT_COMMA	8
+#define LIFT_LONG	16	/* cast to long, for a task's arguments */
+
+/* How a variable of a समानांतर body is used, as far as is known yet. */
+#define PAR_READ	1	/* scalar read before any write */
+#define PAR_PRIVATE	2	/* scalar written first, once per iteration */
+#define PAR_REDUCE	4
+#define PAR_WRITE	8	/* array element written */
+#define PAR_INDEXED	16	/* array indexed at loop variable + paroff */
+#define PAR_IRREGULAR	32	/* array indexed anywhere else */
+
+/* Declarations in an outlined समानांतर body. */
+#define DECL_LOCAL	1
+#define DECL_ZERO	2
+#define DECL_SHARED	3
+#define DECL_ARRAY	4
+
+/*
+ * A प्रत्येक loop of at most FOR_UNROLL iterations, all known, is unrolled
+ * completely; any other is left for the C compiler to unroll FOR_PARTIAL
+ * times.
+ */
+#define FOR_UNROLL	8
+#define FOR_PARTIAL	4
+
+/* How arguments() spells the arguments of a call. */
+#define ARGS_CALL	0
+#define ARGS_TEMPS	1	/* into temporaries, for a self call */
+#define ARGS_TASK	2	/* into an array, for a समवर्ती call */
+
+/* How a procedure or task uses a variable. */
+#define USE_READ	1
+#define USE_WRITE	2
+
+/* Shapes of expressions, as far as bounds and overflow checking care. */
+#define SHAPE_OTHER	0
+#define SHAPE_CONST	1
+#define SHAPE_VAR	2
+#define SHAPE_RANGE	3
+
+/* A range can only depend on the outermost DEP_BITS loops. */
+#define DEP_BITS	((long) (sizeof(unsigned long) * CHAR_BIT))
+
+/* A site whose index has a known value, decided at the statement's end. */
+#define SITE_STMT	(-2)
+
+/*
+ * Sites left undecided for SITE_WINDOW tokens are checked, and प्रत्येक
+ * loops open that long are not unrolled, which bounds the output held
+ * back for a long loop body.
+ */
+#define SITE_WINDOW	16384
+
+/*
+ * Common subexpressions are all dropped every CSE_WINDOW block statements,
+ * and at most CSE_MAX are available at a time, which bounds the output
+ * held back for their temporaries.  Longer ones are not looked up.
+ */
+#define CSE_WINDOW	16
+#define CSE_MAX		64
+#define CSE_KEY		32	/* tokens, at most */
+
+/*
+ * What is known of the values of a variable.  Its declaration is held
+ * until every assignment to it has been seen, for at most RANGE_WINDOW
+ * tokens; copies between variables are solved for in at most RANGE_ROUNDS
+ * rounds.
+ */
+#define RANGE_NONE	0	/* any long */
+#define RANGE_OPEN	1	/* still being assigned */
+#define RANGE_SOLVING	2
+#define RANGE_FINAL	3
+#define RANGE_WINDOW	16384
+#define RANGE_ROUNDS	32
+
+/*
+ * A memoized procedure's cache: MEMO_BITS bits of hash pick an entry,
+ * keyed on at most MEMO_KEYS arguments and globals.
+ */
+#define MEMO_BITS	8
+#define MEMO_KEYS	8
+
+/* Sources smaller than this are always lexed synchronously. */
+#define PIPE_MIN	(1024 * 1024)
+#define RING_SIZE	4096
+
+/* The source is decoded into a window of this many characters. */
+#define WINDOW		(64 * 1024)
+#define READ_CHUNK	(64 * 1024)
 
 /* 
 * hindi pl0c -- PL/0 Compiler
 * program     = block ";" .
 * 
 * block       = [ "नियत" ident "=" number { "," ident "=" number } ";" ]
-*               [ "चर" ident { "," ident } ";" ]
-*               { "प्रक्रिया" ident ";" block ";" } statement .
+*               [ "चर" var { "," var } ";" ]
+*               { "प्रक्रिया" ident [ "(" ident { "," ident } ")" ] ";"
+*                 block ";" } statement .
 * 
-* statement   = [ ident ":=" expression
-*               | "आह्वान" ident
+* var         = ident [ "[" number "]" ] .
+* 
+* statement   = [ ident [ "[" expression "]" ] ":=" expression
+*               | [ "समवर्ती" ] "आह्वान" ident [ arguments ]
+*               | "प्रतीक्षा"
+*               | "लौटाओ" expression
+*               | "समानांतर" ident ":=" expression "तक" expression
+*                 [ "संचय" ident { "," ident } ] "करो" statement
+*               | "प्रत्येक" ident ":=" expression "तक" expression
+*                 [ "कदम" [ "-" ] ( number | ident ) ] "करो" statement
 *               | "आरम्भ" statement { ";" statement } "समापन"
 *               | "यदि" condition "तो" statement
 *               | "जबतक" condition "करो" statement ] .
@@ -71,25 +282,403 @@
 * 
 * expression  = [ "+" | "-" ] term { ( "+" | "-" ) term } .
 * term        = factor { ( "*" | "/" ) factor } .
-* factor      = ident
+* factor      = ident [ "[" expression "]" | arguments ]
 *               | number
 *               | "(" expression ")" .
+* arguments   = "(" [ expression { "," expression } ] ")" .
 * ident       = "अ-ह" { "अ-ह0-9_" } .
 * number      = "0" | "1" | "2" | "3" | "4" | "5" | "6" | "7" | "8" | "9" .
 */ 
 
-static wchar_t *raw, *token;
-static int depth, type;
-static size_t line = 1;
-static long proc = 0;
+static wchar_t *raw, *rawend, *window;
+static const wchar_t *token;
+static int depth, type, pipelined, srcfd, srceof;
+static size_t line = 1, lexline = 1, wincap;
+static off_t srcsize;		/* -1 for a pipe or terminal */
+static const char *srcname;
+static long tokval, lexval;
+static HashNode *tokid, *lexid;
+
+/*
+ * One lexed token, as handed from the lexer to the parser.
+ */
+struct tokrec {
+	int type;
+	size_t line;
+	union {
+		HashNode *id;
+		long value;
+		const char *msg;
+	} u;
+};
+
+/*
+ * Single-producer/single-consumer token ring used by the pipelined
+ * front end.  Each side keeps a private copy of the other's index and
+ * only reloads it when the ring looks full (or empty).
+ */
+static struct {
+	_Alignas(64) atomic_size_t head;
+	_Alignas(64) atomic_size_t tail;
+	_Alignas(64) struct tokrec buf[RING_SIZE];
+} ring;
+static size_t headcache, tailcache;
+
+/*
+ * Growable byte buffer for writing intermediate files.
+ */
+struct buf {
+	unsigned char *p;
+	size_t len;
+	size_t cap;
+};
+
+/*
+ * Intermediate file state.  Writers intern every symbol they reference
+ * into strtab; readers map the file and rebuild the symbols up front.
+ */
+static struct buf strtab, body;
+static HashNode *instrs;
+static size_t nstrs, ninstrs;
+static const unsigned char *inp, *inend;
+static int irout;
+
+/* Arithmetic traps on overflow and division by 0 (-C). */
+static int checking;
+
+/* The program profiles its procedures, loops, calls and conditions (-p). */
+static int profiling;
+
+/* The program brings its own runtime, instead of the C library's. */
+static int freestanding;
+
+/* Calls to pure procedures go through a cache (--memo). */
+static int memoizing;
+
+/*
+ * A profile read back (--profile-use).  Sites are kept as lines counted
+ * from their procedure's own, so that a profile still fits a source that
+ * has changed elsewhere, and sites of a kind sharing a line by their
+ * order on it.
+ */
+#define PROF_HOT	1000	/* calls that make a procedure or site hot */
+#define PROF_HOTPCT	5.0	/* or this share of the samples */
+#define PROF_SURE	90.0	/* percent one way that earns a branch hint */
+#define PROF_TESTS	100	/* tests of a condition before it is trusted */
+
+struct profproc {
+	wchar_t *name;
+	long line;
+	unsigned long calls;
+	double total;
+};
+struct profsite {
+	int kind;		/* 'l'oop, 'c'all, 't'ask or 'i'f (a condition) */
+	long proc;		/* in profprocs */
+	long off;
+	long at;		/* among its kind's sites on its line, from 1 */
+	unsigned long count;
+	double taken;		/* percent, of a condition */
+	wchar_t *callee;
+};
+static struct profproc *profprocs;
+static struct profsite *profsites;
+static size_t nprofprocs, nprofsites;
+static int profusing;
 
+/*
+ * Symbol names point at the interned identifier, so two names are the
+ * same symbol exactly when the pointers are equal.
+ */
 struct symtab {
 	int depth;
 	int type;
-	wchar_t *name;
+	const wchar_t *name;
+	HashNode *id;
+	struct proc *owner;	/* declaring procedure, NULL in main */
+	struct proc *proc;	/* of a procedure symbol */
+	int param;
+	int counting;		/* variable of an enclosing प्रत्येक loop */
+	int paruse;
+	long paroff;
+	long size;		/* elements, for arrays */
+	long value;		/* of a constant, or of a variable if known */
+	int known;
+	long entry;		/* value on entry to the innermost loop */
+	int entryknown;
+	int cses;		/* reads in available common subexpressions */
+	int range;		/* RANGE_NONE, ... */
+	long lo, hi;		/* of the values it may hold */
+	int parity;		/* may be even (1), odd (2) */
+	long typeslot;		/* of its declaration's type */
 	struct symtab *next;
 };
-static struct symtab *head;
+static struct symtab *head, *graveyard;
+
+/*
+ * Variables a procedure or task reads and writes, and procedures it
+ * calls, each listed once.
+ */
+struct use {
+	struct symtab *sym;
+	struct proc *proc;
+	int how;
+};
+struct uses {
+	struct use *v;
+	size_t n, cap;
+};
+
+/*
+ * A procedure.  Nested procedures become top-level C functions, and the
+ * variables of enclosing procedures they use are lifted into pointer
+ * parameters.  Nested procedures can call each other and their
+ * ancestors, so what a procedure has to lift is only known once the
+ * outermost procedure around it ends; until then each place the lifted
+ * variables show up in the output is left as a slot.
+ */
+struct proc {
+	struct symtab *sym;
+	struct proc *parent;
+	long num;		/* tells nested procedures apart, 0 if not */
+	long nparams;
+	struct symtab **own;	/* variables and parameters */
+	size_t nown, owncap;
+	struct symtab **lifted;
+	size_t nlifted, liftcap;
+	long proto, params, defs, undefs;
+	int tail;		/* has a self tail call */
+	int spawned;		/* run by a समवर्ती call */
+	int impure;		/* does I/O or runs tasks, or calls what does */
+	int memo;		/* its calls go through a cache */
+	struct uses uses;	/* of others' variables, and calls */
+	struct uses reach;	/* of others' variables, through calls too */
+};
+static struct proc *curproc, **procs;
+static size_t nprocs, proccap;
+static long nested, nslots;
+
+/*
+ * A call to a nested procedure, whose lifted arguments are still open.
+ */
+struct call {
+	struct proc *caller;
+	struct proc *callee;
+	long slot;
+	int spawn;		/* a समवर्ती call, packing them as longs */
+};
+static struct call *calls;
+static size_t ncalls, callcap;
+
+/*
+ * The समानांतर loop being parsed.  Its body becomes a C function run over
+ * chunks of the iteration range; iterations must not depend on each
+ * other.
+ */
+struct par {
+	struct symtab *index;
+	long num;
+	int depth;		/* of यदि and जबतक inside the body */
+};
+static struct par *par;
+static long nparallel;
+
+/*
+ * A समवर्ती call, with whatever may run alongside it until it is joined:
+ * what the calling function does meanwhile, and the tasks it starts.
+ * Races are looked for once every procedure involved is complete.
+ */
+struct task {
+	struct proc *callee;
+	struct uses with;
+	size_t line;
+};
+static struct task *tasks;
+static size_t ntasks, taskcap;
+
+/*
+ * State of the function being parsed: the tasks that may still be
+ * running, what each enclosing जबतक loop uses (a task left running at
+ * the end of the body runs alongside all of it), and the slots that
+ * join its tasks before a लौटाओ.
+ */
+static size_t *running;
+static size_t nrunning, runcap;
+static struct uses *taskloops;
+static size_t ntaskloops, taskloopcap;
+static long *joins;
+static size_t njoins, joincap;
+static long taskgroup;
+static int tasking;
+
+/*
+ * Procedures run as tasks, called through a function of their own that
+ * unpacks the argument array.
+ */
+struct thunk {
+	HashNode *id;
+	long num;
+	long nparams;
+	long nlifted;
+};
+static struct thunk *thunks;
+static size_t nthunks, thunkcap;
+
+/*
+ * What the last expression parsed is known to be: a constant (off), a
+ * scalar variable plus a constant offset, a value in [lo, hi] as long as
+ * the loops in deps (a bit per index into loops) stay ok, or anything
+ * else.
+ */
+struct shape {
+	int kind;
+	struct symtab *sym;
+	long off;
+	long lo, hi;
+	unsigned long deps;
+};
+static struct shape shape, cond[2];
+static int condop;
+
+/*
+ * An enclosing जबतक loop.  If its condition is "v < n" and v has a known
+ * value lo on entry, v is in [lo, n - 1] at the top of the body.  That
+ * holds on every iteration while each assignment to v keeps v >= lo (ok),
+ * and up to the first assignment to v in the body (modified).
+ */
+struct loop {
+	struct symtab *sym;
+	long lo;
+	long hi;
+	int ok;
+	int modified;
+	size_t firstsite;
+};
+static struct loop *loops;
+static size_t nloops, loopcap;
+
+/*
+ * An array subscript whose bounds check, or an operator whose overflow
+ * check, is still undecided.  Sites are numbered in order; the code
+ * generator numbers them the same way.
+ */
+struct site {
+	long loop;		/* into loops, SITE_STMT, or -1 once resolved */
+	long off;
+	long size;
+	long open, close;	/* output slots */
+	int safe;
+	int arith;		/* an operator, with a second slot after open */
+	unsigned long deps;	/* outer loops to decide after loop */
+};
+static struct site *sites;
+static size_t sitebase, nsites, sitecap, sitepending, stmtfirst;
+static unsigned long sitetoken;	/* the token the pending sites began at */
+static size_t nfors;			/* प्रत्येक loops open */
+static unsigned long fortoken;		/* the token they may unroll from */
+
+/*
+ * A parenthesised expression of scalars and constants whose value is
+ * available, keyed by its tokens.  Its first copy runs from slot a to
+ * slot b.  Used again, it is assigned to __e<a> there and declared in
+ * decl, the slot in front of the block statement that computed it.
+ * Until its full expression ends it is pending: C leaves the order of
+ * evaluation within one open, so a pending value can only be used again
+ * by hoisting its first copy into decl.
+ */
+struct csetok {
+	int type;
+	struct symtab *sym;
+	long value;
+};
+struct cse {
+	struct csetok *key;
+	size_t len;
+	unsigned long hash;
+	long a, b;
+	long decl;		/* -1 once hoisted */
+	size_t stmt;		/* the block statement it was computed in */
+	unsigned long uses;
+	int pending;
+};
+static struct cse cses[CSE_MAX];
+static size_t ncses;
+
+/* A parenthesised expression being parsed; a is -1 if it cannot count. */
+struct paren {
+	long a;
+	size_t key;		/* its first token in csekeys */
+	unsigned long ops;
+	unsigned long impure;
+};
+
+/* A use of the value of slot a in place of the copy from slot at. */
+struct cseuse {
+	long a;
+	long at;
+};
+
+static struct csetok *csekeys;
+static size_t ncsekeys, csekeycap;
+static struct cseuse *cseused;
+static size_t ncseused, cseusecap;
+static long *csedecls;		/* of the enclosing block statements */
+static size_t ncsedecls, csedeclcap;
+static size_t csestmt, csedepth;
+static unsigned long cseops, cseimpure;
+static int csefirst;		/* in a block statement's first expression */
+static int csecalled;		/* after a call in the current statement */
+
+/*
+ * Variables whose ranges are open, and what they wait on: "to" takes
+ * the values of "from" plus off; sym's values depend on the loops in
+ * deps staying ok.
+ */
+struct copy {
+	struct symtab *to, *from;
+	long off;
+};
+struct rangedep {
+	struct symtab *sym;
+	unsigned long deps;
+};
+static struct symtab **rangevars;
+static size_t nrangevars, rangevarcap, nopen;
+static struct copy *copies;
+static size_t ncopies, copycap;
+static struct rangedep *rangedeps;
+static size_t nrangedeps, rangedepcap;
+static unsigned long rangebase;	/* the token the open ranges began at */
+
+/*
+ * A condition that ranges may prove constant: its text runs from slot a
+ * to slot b.  A side is a constant, or a variable plus off until its
+ * range is final.
+ */
+struct side {
+	struct symtab *sym;
+	long off;
+	long lo, hi;
+	int parity;
+};
+struct fold {
+	long a, b;
+	int op;
+	struct side side[2];
+};
+static struct fold *folds;
+static size_t nfolds, foldcap;
+
+/* Whether the value just parsed is a long in C, and is to be cast so. */
+static int wide, castnext;
+
+/* What --stats reports. */
+static struct {
+	unsigned long cse, temps;
+	unsigned long arrays, narrowed, folded;
+	unsigned long procs, memo;
+} optstats;
+static int reporting;
 
 HashMap* map;
 
@@ -114,47 +703,306 @@ error(const char *fmt, ...)
 }
 
 static void
-readin(char *file)
+warning(const char *fmt, ...)
 {
-	int fd;
-	struct stat st;
+	va_list ap;
 
-	if (strrchr(file, '.') == NULL)
-		error("file must end in '.hindi'");
+	(void) fprintf(stderr, "[WARNING] %lu: ", line);
 
-	if (!!strcmp(strrchr(file, '.'), ".hindi"))
-		error("file must end in '.hindi'");
+	va_start(ap, fmt);
+	(void) vfprintf(stderr, fmt, ap);
+	va_end(ap);
 
-	if ((fd = open(file, O_RDONLY)) == -1)
-		error("couldn't open %s", file);
+	(void) fputc('\n', stderr);
+}
 
-	if (fstat(fd, &st) == -1)
-		error("couldn't get file size");
+/*
+ * Phase timing (--time-report).  Time is charged to whichever phase is
+ * innermost when the clock is read, so on one thread the phases add up
+ * to the whole run.  A pipelined lexer is timed on its own thread, and
+ * overlaps the others.
+ */
 
-	char *raw_bytes;
-    if ((raw_bytes = malloc(st.st_size + 1)) == NULL)
-        error("malloc failed");
+#define PH_READ		0	/* reading and converting the source */
+#define PH_LEX		1
+#define PH_PARSE	2
+#define PH_SYMBOLS	3	/* symcheck() and addsymbol() */
+#define PH_EMIT		4	/* formatting and writing output */
+#define NPHASES		5
 
-    if (read(fd, raw_bytes, st.st_size) != st.st_size)
-        error("couldn't read %s", file);
-    raw_bytes[st.st_size] = '\0';
+static const char *phasenames[NPHASES] = {
+	"read", "lex", "parse", "symbols", "emit"
+};
 
-    size_t wlen = mbstowcs(NULL, raw_bytes, 0); 
-    if (wlen == (size_t)-1)
-        error("invalid multibyte sequence");
+static struct {
+	double wall, cpu;
+} phases[NPHASES];
 
-    raw = malloc((wlen + 1) * sizeof(wchar_t));
-    if (!raw)
-        error("malloc failed");
+static struct {
+	unsigned long tokens, idents, symbols, probes, emitted;
+} stats;
 
-    mbstowcs(raw, raw_bytes, wlen + 1);
-    free(raw_bytes);
+static int timing, phase = PH_PARSE;
+static double phwall, phcpu, startwall, startcpu;
+static double lexwall, lexcpu;
+static double pending[NPHASES], cpuwall;
 
-	token = malloc((wlen + 1) * sizeof(wchar_t));
-	if (!token)
-		error("malloc failed for token");
+#define CPU_WINDOW	1e-3	/* seconds between reads of the CPU clock */
 
-	(void) close(fd);
+static double
+seconds(clockid_t clock)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(clock, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Charge the CPU time used since the last read to the phases, in
+ * proportion to the wall time each has had since then.
+ */
+static void
+chargecpu(double wall)
+{
+	double cpu, sum = 0;
+	int i;
+
+	cpu = seconds(CLOCK_THREAD_CPUTIME_ID);
+	for (i = 0; i < NPHASES; i++)
+		sum += pending[i];
+	for (i = 0; i < NPHASES; i++) {
+		if (sum > 0)
+			phases[i].cpu += (cpu - phcpu) * pending[i] / sum;
+		pending[i] = 0;
+	}
+	phcpu = cpu;
+	cpuwall = wall;
+}
+
+/*
+ * Switch to phase p, returning the phase to switch back to.  The lexer
+ * and the output routines switch once or twice a token, too often for
+ * the thread CPU clock, which is a system call: only the monotonic clock
+ * is read on every switch, and CPU time is read at most once a
+ * millisecond and shared out by wall time.  Wall times and the CPU total
+ * are exact; a phase's CPU time is exact to within that window.
+ */
+static int
+enter(int p)
+{
+	int prev = phase;
+	double wall;
+
+	if (!timing)
+		return prev;
+
+	wall = seconds(CLOCK_MONOTONIC);
+	phases[phase].wall += wall - phwall;
+	pending[phase] += wall - phwall;
+	phwall = wall;
+	phase = p;
+	if (wall - cpuwall >= CPU_WINDOW)
+		chargecpu(wall);
+	return prev;
+}
+
+static void
+starttiming(void)
+{
+
+	timing = 1;
+	phwall = startwall = cpuwall = seconds(CLOCK_MONOTONIC);
+	phcpu = startcpu = seconds(CLOCK_THREAD_CPUTIME_ID);
+}
+
+/*
+ * Print the report to stderr, as a table or (json) as one JSON object.
+ * ru_maxrss is in kilobytes.
+ */
+static void
+timereport(const char *file, int json)
+{
+	struct rusage ru;
+	double wall, cpu;
+	const char *p;
+	int i, distinct = map->count + (int) ninstrs;
+
+	if (!timing)
+		return;
+
+	(void) enter(phase);
+	chargecpu(phwall);
+	wall = phwall - startwall;
+	cpu = phcpu - startcpu;
+	phases[PH_LEX].wall += lexwall;
+	phases[PH_LEX].cpu += lexcpu;
+	(void) getrusage(RUSAGE_SELF, &ru);
+
+	if (!json) {
+		(void) fprintf(stderr, "[INFO] time report for %s\n", file);
+		(void) fprintf(stderr, "%-10s %12s %12s\n", "phase",
+		    "wall ms", "cpu ms");
+		for (i = 0; i < NPHASES; i++)
+			(void) fprintf(stderr, "%-10s %12.3f %12.3f\n",
+			    phasenames[i], phases[i].wall * 1e3,
+			    phases[i].cpu * 1e3);
+		(void) fprintf(stderr, "%-10s %12.3f %12.3f\n", "total",
+		    wall * 1e3, cpu * 1e3);
+		(void) fprintf(stderr, "tokens %lu, identifiers %lu "
+		    "(%d distinct), symbols %lu, symbol probes %lu\n",
+		    stats.tokens, stats.idents, distinct, stats.symbols,
+		    stats.probes);
+		(void) fprintf(stderr, "bytes emitted %lu, peak RSS %ld KiB\n",
+		    stats.emitted, ru.ru_maxrss);
+		return;
+	}
+
+	(void) fputs("{\"file\":\"", stderr);
+	for (p = file; *p != '\0'; p++) {
+		if ((unsigned char) *p < 0x20) {
+			(void) fprintf(stderr, "\\u%04x", (unsigned char) *p);
+			continue;
+		}
+		if (*p == '"' || *p == '\\')
+			(void) fputc('\\', stderr);
+		(void) fputc(*p, stderr);
+	}
+	(void) fputs("\",\"phases\":{", stderr);
+	for (i = 0; i < NPHASES; i++)
+		(void) fprintf(stderr, "%s\"%s\":{\"wall_ms\":%.3f,"
+		    "\"cpu_ms\":%.3f}", i ? "," : "", phasenames[i],
+		    phases[i].wall * 1e3, phases[i].cpu * 1e3);
+	(void) fprintf(stderr, "},\"total\":{\"wall_ms\":%.3f,"
+	    "\"cpu_ms\":%.3f},", wall * 1e3, cpu * 1e3);
+	(void) fprintf(stderr, "\"tokens\":%lu,\"identifiers\":%lu,"
+	    "\"distinct_identifiers\":%d,\"symbols\":%lu,"
+	    "\"symbol_probes\":%lu,\"bytes_emitted\":%lu,"
+	    "\"peak_rss_kib\":%ld}\n", stats.tokens, stats.idents, distinct,
+	    stats.symbols, stats.probes, stats.emitted, ru.ru_maxrss);
+}
+
+/*
+ * What the optimizations did (--stats).
+ */
+static void
+optreport(const char *file)
+{
+
+	if (!reporting)
+		return;
+
+	(void) fprintf(stderr, "[INFO] optimization report for %s\n", file);
+	(void) fprintf(stderr, "common subexpressions eliminated %lu, "
+	    "temporaries %lu\n", optstats.cse, optstats.temps);
+	(void) fprintf(stderr, "arrays narrowed %lu of %lu, conditions "
+	    "proved constant %lu\n", optstats.narrowed, optstats.arrays,
+	    optstats.folded);
+	if (memoizing)
+		(void) fprintf(stderr, "procedures memoized %lu of %lu\n",
+		    optstats.memo, optstats.procs);
+}
+
+/*
+ * The source is read as a stream, "-" being stdin, and the lexer works
+ * in a window over it.  Only an identifier is ever kept across a refill,
+ * so memory stays the window's however long the source is.
+ */
+static void
+readin(const char *file)
+{
+	const char *suffix = strrchr(file, '.');
+	struct stat st;
+
+	srcname = file;
+	if (!strcmp(file, "-"))
+		srcfd = STDIN_FILENO;
+	else if (suffix == NULL || strcmp(suffix, ".hindi") != 0)
+		error("file must end in '.hindi'");
+	else if ((srcfd = open(file, O_RDONLY)) == -1)
+		error("couldn't open %s", file);
+
+	srcsize = -1;
+	if (fstat(srcfd, &st) == 0 && S_ISREG(st.st_mode))
+		srcsize = st.st_size;
+
+	wincap = WINDOW;
+	if ((window = calloc(wincap + 1 + SCAN_PAD, sizeof(wchar_t))) == NULL)
+		error("malloc failed");
+	raw = rawend = window;
+}
+
+/*
+ * Move the characters from *keep on to the front of the window, with
+ * *keep and raw, and decode more of the source after them.  A UTF-8
+ * sequence split between reads is finished by the next.  Returns 0 at
+ * the end of the source, when nothing more could be added.
+ */
+static int
+refill(wchar_t **keep)
+{
+	static char bytes[READ_CHUNK];
+	static size_t nbytes;
+	static mbstate_t mbs;
+	size_t kept = rawend - *keep, off = raw - *keep, n;
+	const char *src;
+	wchar_t *full;
+	ssize_t r;
+	int ph = 0;
+
+	if (!pipelined)
+		ph = enter(PH_READ);
+
+	/* Only an identifier longer than half the window outgrows it. */
+	if (kept > wincap / 2) {
+		n = *keep - window;
+		wincap *= 2;
+		window = realloc(window,
+		    (wincap + 1 + SCAN_PAD) * sizeof(wchar_t));
+		if (window == NULL)
+			error("malloc failed");
+		*keep = window + n;
+	}
+	(void) wmemmove(window, *keep, kept);
+	*keep = window;
+	raw = window + off;
+	rawend = window + kept;
+	full = window + wincap;
+
+	for (;;) {
+		src = bytes;
+		n = mbsnrtowcs(rawend, &src, nbytes, full - rawend, &mbs);
+		if (n == (size_t) -1)
+			error("invalid multibyte sequence");
+		rawend += n;
+		if (src == NULL) {	/* a NUL, which ends the source */
+			srceof = 1;
+			nbytes = 0;
+		} else {
+			nbytes -= src - bytes;
+			(void) memmove(bytes, src, nbytes);
+		}
+
+		if (rawend > window + kept || srceof)
+			break;
+		r = read(srcfd, bytes + nbytes, sizeof(bytes) - nbytes);
+		if (r == -1 && errno == EINTR)
+			continue;
+		if (r == -1)
+			error("couldn't read %s", srcname);
+		if (r == 0) {
+			srceof = 1;
+			(void) close(srcfd);
+			if (nbytes != 0 || !mbsinit(&mbs))
+				error("invalid multibyte sequence");
+		}
+		nbytes += r;
+	}
+	(void) wmemset(rawend, L'\0', 1 + SCAN_PAD);
+
+	if (!pipelined)
+		enter(ph);
+	return rawend > window + kept;
 }
 
 /*
@@ -177,29 +1025,55 @@ initsymtab(void)
 	head = new;
 }
 
+/*
+ * Remember the variables a procedure declares, to check lifted names
+ * against once the procedure's own symbols are gone.
+ */
 static void
+own(struct symtab *sym)
+{
+	struct proc *p = curproc;
+
+	if (p == NULL || sym->type != TOK_VAR)
+		return;
+
+	if (p->nown == p->owncap) {
+		p->owncap = p->owncap ? p->owncap * 2 : 8;
+		p->own = realloc(p->own, p->owncap * sizeof(*p->own));
+		if (p->own == NULL)
+			error("malloc failed");
+	}
+	p->own[p->nown++] = sym;
+}
+
+static struct symtab *
 addsymbol(int type)
 {
     struct symtab *curr, *new;
+    int ph = enter(PH_SYMBOLS);
 
+    stats.symbols++;
     if (head == NULL) {
-        head = malloc(sizeof(struct symtab));
+        head = calloc(1, sizeof(struct symtab));
         if (head == NULL)
             error("malloc failed");
 
         head->depth = depth - 1;
         head->type = type;
-        head->name = wcsdup(token);
-        if (head->name == NULL)
-            error("malloc failed");
+        head->name = token;
+        head->id = tokid;
+        head->owner = curproc;
 
         head->next = NULL;
-        return;
+        own(head);
+        enter(ph);
+        return head;
     }
 
     curr = head;
     while (1) {
-        if (!wcscmp(curr->name, token)) {
+        stats.probes++;
+        if (curr->name == token) {
             if (curr->depth == (depth - 1))
                 error("duplicate symbol: %ls", token);
         }
@@ -210,20 +1084,28 @@ addsymbol(int type)
         curr = curr->next;
     }
 
-    new = malloc(sizeof(struct symtab));
+    new = calloc(1, sizeof(struct symtab));
     if (new == NULL)
         error("malloc failed");
 
     new->depth = depth - 1;
     new->type = type;
-    new->name = wcsdup(token);
-    if (new->name == NULL)
-        error("malloc failed");
+    new->name = token;
+    new->id = tokid;
+    new->owner = curproc;
 
     new->next = NULL;
     curr->next = new;
+
+    own(new);
+    enter(ph);
+    return new;
 }
 
+/*
+ * Symbols leaving scope are kept until the outermost procedure ends, as
+ * lifted variables still refer to them.
+ */
 static void
 destroysymbols(void)
 {
@@ -239,8 +1121,8 @@ destroysymbols(void)
                 head = curr->next;
 
             curr = curr->next;
-            free(to_free->name);
-            free(to_free);
+            to_free->next = graveyard;
+            graveyard = to_free;
         } else {
             prev = curr;
             curr = curr->next;
@@ -248,34 +1130,42 @@ destroysymbols(void)
     }
 }
 
-static void
+static struct symtab *
 symcheck(int check)
 {
 	struct symtab *curr, *ret = NULL;
+	int ph = enter(PH_SYMBOLS);
 
 	curr = head;
 	while (curr != NULL) {
-		if (!wcscmp(token, curr->name))
+		if (curr->name == token)
 			ret = curr;
 		curr = curr->next;
+		stats.probes++;
 	}
 
 	if (ret == NULL)
-		error("undefined symbol: %s", token);
+		error("undefined symbol: %ls", token);
 
 	switch (check) {
 	case CHECK_LHS:
 		if (ret->type != TOK_VAR)
-			error("must be a variable: %s", token);
+			error("must be a variable: %ls", token);
 		break;
 	case CHECK_RHS:
 		if (ret->type == TOK_PROCEDURE)
-			error("must not be a procedure: %s", token);
+			error("must not be a procedure: %ls", token);
 		break;
 	case CHECK_CALL:
 		if (ret->type != TOK_PROCEDURE)
-			error("must be a procedure: %s", token);
+			error("must be a procedure: %ls", token);
+		break;
+	case CHECK_ANY:
+		break;
 	}
+
+	enter(ph);
+	return ret;
 }
 
 
@@ -283,18 +1173,46 @@ symcheck(int check)
  * Lexer.
  */
 
+static void ring_put(const struct tokrec *);
+
+/*
+ * Lexical errors are reported against the lexer's line.  When the lexer
+ * runs on its own thread the message is queued behind the tokens already
+ * produced, so the parser reports errors in source order.
+ */
 static void
-comment(void)
+lexerror(const char *fmt, ...)
 {
-	int ch;
+	static char msg[256];
+	struct tokrec t;
+	va_list ap;
+
+	va_start(ap, fmt);
+	(void) vsnprintf(msg, sizeof(msg), fmt, ap);
+	va_end(ap);
+
+	if (!pipelined) {
+		line = lexline;
+		error("%s", msg);
+	}
 
-	while ((ch = *raw++) != '}') {
-		if (ch == '\0')
-			error("unterminated comment");
+	t.type = TOK_ERROR;
+	t.line = lexline;
+	t.u.msg = msg;
+	ring_put(&t);
 
-		if (ch == '\n')
-			++line;
+	pthread_exit(NULL);
+}
+
+static void
+comment(void)
+{
+
+	while (*(raw = (wchar_t *) scan_comment(raw, &lexline)) == L'\0') {
+		if (raw != rawend || !refill(&raw))
+			lexerror("unterminated comment");
 	}
+	raw++;
 }
 
 static int is_devanagari_combining(wchar_t c) {
@@ -303,71 +1221,101 @@ static int is_devanagari_combining(wchar_t c) {
            (c >= 0x0962 && c <= 0x0963);
 }
 
+static int
+keyword(const wchar_t *s, size_t len, const wchar_t *kw)
+{
+
+	return !wcsncmp(s, kw, len) && kw[len] == L'\0';
+}
+
+/*
+ * Identifiers are matched in place in the source window; only a name
+ * seen for the first time is copied, into the symbol arena.  One cut
+ * off by the end of the window is kept whole across the refill.
+ */
 static int
 ident(void)
 {
     wchar_t *start = raw;
     
     if (!iswalpha(*raw) && !is_devanagari_combining(*raw) && *raw != L'_')
-        error("invalid identifier start: %lc", *raw);
+        lexerror("invalid identifier start: %lc", *raw);
 
     raw++;
 
-    while (*raw != L'\0' && (iswalpha(*raw) || iswdigit(*raw) || *raw == L'_' || is_devanagari_combining(*raw)))
-		raw++;	
+    do {
+        raw = (wchar_t *) scan_ident(raw);
+        while (*raw != L'\0' && (iswalpha(*raw) || iswdigit(*raw) || *raw == L'_' || is_devanagari_combining(*raw)))
+            raw++;
+    } while (raw == rawend && refill(&start));
 
 
     size_t len = raw - start;
-    wcsncpy(token, start, len);
-    token[len] = L'\0';
 
-	if (!wcscmp(token, L"नियत"))
+	if (keyword(start, len, L"नियत"))
 		return TOK_CONST;
-	else if (!wcscmp(token, L"चर"))
+	else if (keyword(start, len, L"चर"))
 		return TOK_VAR;
-	else if (!wcscmp(token, L"प्रक्रिया"))
+	else if (keyword(start, len, L"प्रक्रिया"))
 		return TOK_PROCEDURE;
-	else if (!wcscmp(token, L"आह्वान"))
+	else if (keyword(start, len, L"आह्वान"))
 		return TOK_CALL;
-	else if (!wcscmp(token, L"आरम्भ"))
+	else if (keyword(start, len, L"आरम्भ"))
 		return TOK_BEGIN;
-	else if (!wcscmp(token, L"समापन"))
+	else if (keyword(start, len, L"समापन"))
 		return TOK_END;
-	else if (!wcscmp(token, L"यदि"))
+	else if (keyword(start, len, L"यदि"))
 		return TOK_IF;
-	else if (!wcscmp(token, L"तो"))
+	else if (keyword(start, len, L"तो"))
 		return TOK_THEN;
-	else if (!wcscmp(token, L"जबतक"))
+	else if (keyword(start, len, L"जबतक"))
 		return TOK_WHILE;
-	else if (!wcscmp(token, L"करो"))
+	else if (keyword(start, len, L"करो"))
 		return TOK_DO;
-	else if (!wcscmp(token, L"विषम"))
+	else if (keyword(start, len, L"विषम"))
 		return TOK_ODD;
-	else if (!wcscmp(token, L"अंक_लिखें"))
+	else if (keyword(start, len, L"अंक_लिखें"))
 		return TOK_WRITEINT;
-	else if (!wcscmp(token, L"वर्ण_लिखें"))
+	else if (keyword(start, len, L"वर्ण_लिखें"))
 		return TOK_WRITECHAR;
-	else if (!wcscmp(token, L"अंक_पढ़ें"))
+	else if (keyword(start, len, L"अंक_पढ़ें"))
 		return TOK_READINT;
-	else if (!wcscmp(token, L"वर्ण_पढ़ें"))
+	else if (keyword(start, len, L"वर्ण_पढ़ें"))
 		return TOK_READCHAR;
-	else if (!wcscmp(token, L"में"))
+	else if (keyword(start, len, L"में"))
 		return TOK_INTO;
-
-	insert(map,token);
+	else if (keyword(start, len, L"लौटाओ"))
+		return TOK_RETURN;
+	else if (keyword(start, len, L"समानांतर"))
+		return TOK_PARALLEL;
+	else if (keyword(start, len, L"तक"))
+		return TOK_TO;
+	else if (keyword(start, len, L"संचय"))
+		return TOK_REDUCE;
+	else if (keyword(start, len, L"समवर्ती"))
+		return TOK_SPAWN;
+	else if (keyword(start, len, L"प्रतीक्षा"))
+		return TOK_WAIT;
+	else if (keyword(start, len, L"प्रत्येक"))
+		return TOK_FOR;
+	else if (keyword(start, len, L"कदम"))
+		return TOK_STEP;
+
+	lexid = insert_span(map, start, len);
 	no_ident++;
 	return TOK_IDENT;
 }
 
 static int
 number(void) {
-    wchar_t *start = raw;
-    while (iswdigit(*raw) || isdigit(*raw))
-        raw++;
-
-    size_t len = raw - start;
-    wcsncpy(token, start, len);
-    token[len] = L'\0';
+    lexval = 0;
+    do {
+        while (iswdigit(*raw)) {
+            if (lexval > (LONG_MAX - (*raw - L'0')) / 10)
+                lexerror("number too large");
+            lexval = lexval * 10 + (*raw++ - L'0');
+        }
+    } while (raw == rawend && refill(&raw));
 
     return TOK_NUMBER;
 }
@@ -376,15 +1324,12 @@ static int
 lex(void)
 {
 again:
-    while (*raw == L' ' || *raw == L'\t' || *raw == L'\n') {
-        if (*raw++ == L'\n')
-            ++line;
-    }
+    raw = (wchar_t *) scan_space(raw, &lexline);
 
     if (iswalpha(*raw) || *raw == L'_')
         return ident();
 
-    if (iswdigit(*raw) || isdigit(*raw))
+    if (iswdigit(*raw))
         return number();
 
     switch (*raw) {
@@ -394,364 +1339,6022 @@ again:
     case L'.': case L'=': case L',': case L';':
     case L'#': case L'<': case L'>': case L'+':
     case L'-': case L'*': case L'/': case L'(':
-    case L')':
+    case L')': case L'[': case L']':
         return *raw++;
     case L':':
-        if (*++raw != L'=')
-            error("unknown token: ':%lc'", *raw);
+        if (++raw == rawend)
+            (void) refill(&raw);
+        if (*raw != L'=')
+            lexerror("unknown token: ':%lc'", *raw);
         ++raw;
         return TOK_ASSIGN;
     case L'\0':
+        if (raw == rawend && refill(&raw))
+            goto again;
         return 0;
     default:
-        error("unknown token: '%lc'", *raw);
+        lexerror("unknown token: '%lc'", *raw);
     }
 
     return 0;
 }
 
+static void
+lextok(struct tokrec *t)
+{
+	t->type = lex();
+	t->line = lexline;
+
+	if (t->type == TOK_IDENT)
+		t->u.id = lexid;
+	else if (t->type == TOK_NUMBER)
+		t->u.value = lexval;
+}
+
 /*
- * Code generator.
+ * Pipelined front end.
  */
 
 static void
-aout(const wchar_t *fmt, ...)
+ring_put(const struct tokrec *t)
 {
-    va_list ap;
-    va_start(ap, fmt);
-    vwprintf(fmt, ap);
-    va_end(ap);
+	size_t tail;
+
+	tail = atomic_load_explicit(&ring.tail, memory_order_relaxed);
+	while (tail - headcache == RING_SIZE) {
+		headcache = atomic_load_explicit(&ring.head,
+		    memory_order_acquire);
+		if (tail - headcache == RING_SIZE)
+			sched_yield();
+	}
+
+	ring.buf[tail & (RING_SIZE - 1)] = *t;
+	atomic_store_explicit(&ring.tail, tail + 1, memory_order_release);
 }
 
 static void
-cg_end(void)
+ring_get(struct tokrec *t)
 {
+	size_t head;
+
+	head = atomic_load_explicit(&ring.head, memory_order_relaxed);
+	while (head == tailcache) {
+		tailcache = atomic_load_explicit(&ring.tail,
+		    memory_order_acquire);
+		if (head == tailcache)
+			sched_yield();
+	}
 
+	*t = ring.buf[head & (RING_SIZE - 1)];
+	atomic_store_explicit(&ring.head, head + 1, memory_order_release);
+}
+
+static void *
+lexthread(void *arg)
+{
+	struct tokrec t;
+	double wall = 0;
+
+	(void) arg;
+
+	if (timing)
+		wall = seconds(CLOCK_MONOTONIC);
+	do {
+		lextok(&t);
+		ring_put(&t);
+	} while (t.type != 0);
+	if (timing) {
+		lexwall = seconds(CLOCK_MONOTONIC) - wall;
+		lexcpu = seconds(CLOCK_THREAD_CPUTIME_ID);
+	}
+
+	return NULL;
+}
+
+/*
+ * Intermediate files.
+ *
+ * Token streams (-t) and IR (-i) share one layout, so both can be mapped
+ * and decoded without copying:
+ *
+ *	"HPL0" kind version 0 0		8 bytes
+ *	nstrings			u32, little endian
+ *	strtab size			u32, little endian
+ *	strtab				nstrings x { varint len, UTF-8 name,
+ *					  varint len, C name }
+ *	body				records up to end of file
+ *
+ * A token is a varint type followed, for identifiers and numbers, by a
+ * varint string index or value.  A token stream record is a token and a
+ * varint line delta.  An IR record is an operation byte, two varint
+ * arguments and the token the operation applies to.
+ */
+
+static void
+buf_grow(struct buf *b, size_t n)
+{
+
+	if (b->len + n <= b->cap)
+		return;
+
+	while (b->len + n > b->cap)
+		b->cap = b->cap ? b->cap * 2 : 4096;
+
+	if ((b->p = realloc(b->p, b->cap)) == NULL)
+		error("malloc failed");
+}
+
+static void
+buf_byte(struct buf *b, int c)
+{
+
+	buf_grow(b, 1);
+	b->p[b->len++] = c;
+}
+
+static void
+buf_bytes(struct buf *b, const void *p, size_t n)
+{
+
+	buf_grow(b, n);
+	memcpy(b->p + b->len, p, n);
+	b->len += n;
+}
+
+static void
+buf_varint(struct buf *b, unsigned long v)
+{
+
+	while (v >= 0x80) {
+		buf_byte(b, (v & 0x7f) | 0x80);
+		v >>= 7;
+	}
+	buf_byte(b, v);
+}
+
+static void
+buf_u32(struct buf *b, unsigned long v)
+{
+
+	buf_byte(b, v & 0xff);
+	buf_byte(b, (v >> 8) & 0xff);
+	buf_byte(b, (v >> 16) & 0xff);
+	buf_byte(b, (v >> 24) & 0xff);
+}
+
+static unsigned long
+get_varint(void)
+{
+	unsigned long v = 0;
+	int shift = 0;
+
+	do {
+		if (inp == inend || shift > 63)
+			error("truncated intermediate file");
+		v |= (unsigned long) (*inp & 0x7f) << shift;
+		shift += 7;
+	} while (*inp++ & 0x80);
+
+	return v;
+}
+
+static unsigned long
+get_u32(void)
+{
+	unsigned long v;
+
+	if (inend - inp < 4)
+		error("truncated intermediate file");
+
+	v = inp[0] | inp[1] << 8 | (unsigned long) inp[2] << 16 |
+	    (unsigned long) inp[3] << 24;
+	inp += 4;
+
+	return v;
+}
+
+static unsigned long
+strindex(HashNode *id)
+{
+	char name[1024];
+	size_t len;
+
+	if (id->index >= 0)
+		return id->index;
+
+	if ((len = wcstombs(name, id->key, sizeof(name))) == (size_t) -1 ||
+	    len == sizeof(name))
+		error("identifier too long: %ls", id->key);
+
+	buf_varint(&strtab, len);
+	buf_bytes(&strtab, name, len);
+	len = strlen(id->value);
+	buf_varint(&strtab, len);
+	buf_bytes(&strtab, id->value, len);
+
+	id->index = nstrs;
+
+	return nstrs++;
+}
+
+static void
+put_token(const struct tokrec *t)
+{
+
+	buf_varint(&body, t->type);
+	if (t->type == TOK_IDENT)
+		buf_varint(&body, strindex(t->u.id));
+	else if (t->type == TOK_NUMBER)
+		buf_varint(&body, t->u.value);
+}
+
+static void
+interout(int kind)
+{
+	struct buf hdr = { NULL, 0, 0 };
+
+	buf_bytes(&hdr, "HPL0", 4);
+	buf_byte(&hdr, kind);
+	buf_byte(&hdr, INTER_VERSION);
+	buf_byte(&hdr, 0);
+	buf_byte(&hdr, 0);
+	buf_u32(&hdr, nstrs);
+	buf_u32(&hdr, strtab.len);
+
+	if (fwrite(hdr.p, 1, hdr.len, stdout) != hdr.len ||
+	    fwrite(strtab.p, 1, strtab.len, stdout) != strtab.len ||
+	    fwrite(body.p, 1, body.len, stdout) != body.len ||
+	    fflush(stdout) == EOF)
+		error("couldn't write intermediate file");
+	stats.emitted += hdr.len + strtab.len + body.len;
+
+	free(hdr.p);
+	free(strtab.p);
+	free(body.p);
+}
+
+/*
+ * Lex the whole source into a token stream.
+ */
+static void
+tokout(void)
+{
+	struct tokrec t;
+	size_t last = 1;
+	int ph;
+
+	do {
+		ph = enter(PH_LEX);
+		lextok(&t);
+		enter(PH_EMIT);
+		put_token(&t);
+		buf_varint(&body, t.line - last);
+		last = t.line;
+		enter(ph);
+		stats.tokens++;
+		if (t.type == TOK_IDENT)
+			stats.idents++;
+	} while (t.type != 0);
+
+	ph = enter(PH_EMIT);
+	interout(KIND_TOKENS);
+	enter(ph);
+}
+
+/*
+ * Record a code generator operation instead of emitting C.  The token is
+ * the current one unless the operation names a symbol of its own.
+ */
+static void
+ir_put(int op, long arg, long arg2, HashNode *id)
+{
+	struct tokrec t;
+	int ph = enter(PH_EMIT);
+
+	t.type = type;
+	if (id != NULL) {
+		t.type = TOK_IDENT;
+		t.u.id = id;
+	} else if (type == TOK_IDENT)
+		t.u.id = tokid;
+	else if (type == TOK_NUMBER)
+		t.u.value = tokval;
+
+	buf_byte(&body, op);
+	buf_varint(&body, arg);
+	buf_varint(&body, arg2);
+	buf_varint(&body, line);
+	put_token(&t);
+	enter(ph);
+}
+
+#define IR_HOOK_ID(op, arg, arg2, id)				\
+	do {							\
+		if (irout) {					\
+			ir_put((op), (arg), (arg2), (id));	\
+			return;					\
+		}						\
+	} while (0)
+
+#define IR_HOOK(op, arg, arg2)	IR_HOOK_ID(op, arg, arg2, NULL)
+
+/*
+ * Map an intermediate file and rebuild its symbols.
+ */
+static void
+interin(char *file, int kind)
+{
+	const unsigned char *tab;
+	struct stat st;
+	wchar_t *key;
+	size_t i, len, strsize;
+	int fd, ph = enter(PH_READ);
+
+	if ((fd = open(file, O_RDONLY)) == -1)
+		error("couldn't open %s", file);
+
+	if (fstat(fd, &st) == -1)
+		error("couldn't get file size");
+
+	if (st.st_size < 16)
+		error("%s: not an intermediate file", file);
+
+	inp = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (inp == MAP_FAILED)
+		error("couldn't map %s", file);
+	inend = inp + st.st_size;
+
+	(void) close(fd);
+
+	if (memcmp(inp, "HPL0", 4) != 0 || inp[4] != kind)
+		error("%s: not an intermediate file", file);
+	if (inp[5] != INTER_VERSION)
+		error("%s: unsupported version %d", file, inp[5]);
+	inp += 8;
+
+	ninstrs = get_u32();
+	strsize = get_u32();
+	if (strsize > (size_t) (inend - inp))
+		error("truncated intermediate file");
+
+	if ((instrs = calloc(ninstrs ? ninstrs : 1, sizeof(HashNode))) == NULL)
+		error("malloc failed");
+
+	tab = inp;
+	for (i = 0; i < ninstrs; i++) {
+		char name[1024];
+
+		len = get_varint();
+		if (len >= sizeof(name) || len > (size_t) (inend - inp))
+			error("truncated intermediate file");
+		memcpy(name, inp, len);
+		name[len] = '\0';
+		inp += len;
+
+		if ((key = malloc((len + 1) * sizeof(wchar_t))) == NULL)
+			error("malloc failed");
+		if (mbstowcs(key, name, len + 1) == (size_t) -1)
+			error("invalid multibyte sequence");
+
+		len = get_varint();
+		if (len >= sizeof(name) || len > (size_t) (inend - inp))
+			error("truncated intermediate file");
+		memcpy(name, inp, len);
+		name[len] = '\0';
+		inp += len;
+
+		instrs[i].key = key;
+		if ((instrs[i].value = strdup(name)) == NULL)
+			error("malloc failed");
+		instrs[i].index = -1;
+	}
+
+	if ((size_t) (inp - tab) != strsize)
+		error("corrupt string table");
+	enter(ph);
+}
+
+static HashNode *
+get_string(void)
+{
+	unsigned long i;
+
+	if ((i = get_varint()) >= ninstrs)
+		error("string index out of range");
+
+	return &instrs[i];
+}
+
+static void
+get_token(struct tokrec *t)
+{
+
+	t->type = get_varint();
+	if (t->type == TOK_IDENT)
+		t->u.id = get_string();
+	else if (t->type == TOK_NUMBER)
+		t->u.value = get_varint();
+}
+
+/*
+ * Token source reading a token stream back in place of the lexer.
+ */
+static void
+tokin(struct tokrec *t)
+{
+
+	get_token(t);
+	lexline += get_varint();
+	t->line = lexline;
+}
+
+static void
+interfree(void)
+{
+	size_t i;
+
+	for (i = 0; i < ninstrs; i++) {
+		free(instrs[i].key);
+		free(instrs[i].value);
+	}
+	free(instrs);
+}
+
+/*
+ * Code generator.
+ */
+
+/*
+ * Output is held back while any slot in it is open: the bounds check
+ * around an array index, or the lifted parameters and arguments of a
+ * nested procedure.  Slots are numbered in the order they were opened,
+ * which is also their order in the held output.
+ */
+struct cgslot {
+	size_t at;
+	wchar_t *text;
+	size_t len;
+	size_t cap;
+	int open;
+	long end;		/* of a common subexpression's first copy */
+};
+static struct cgslot *cgslots;
+static size_t cgbase, ncgslots, cgslotcap, cgpending;
+static wchar_t *held;
+static size_t heldlen, heldcap;
+
+/*
+ * Output moved out of the held output, to be put back elsewhere.
+ */
+struct wbuf {
+	wchar_t *p;
+	size_t len;
+	size_t cap;
+};
+
+/*
+ * Output diverted out of a function, to follow it: the outlined bodies
+ * of its समानांतर loops.
+ */
+static size_t divertat;
+static struct wbuf outlined;
+static int parruntime;
+
+/*
+ * प्रत्येक loops being generated.  The body is held from a slot that takes
+ * the loop's header, unless the body is unrolled instead; hold is -1
+ * once the header is written.
+ */
+struct cgfor {
+	long num;
+	long hold;
+	long step;
+	HashNode *id;
+};
+static struct cgfor *cgfors;
+static size_t ncgfors, cgforcap;
+static long cgnfor;
+
+/*
+ * Profiled sites (-p, --profile-use): the functions, main last, and the
+ * loops, calls and conditions in them.  A procedure is numbered at its
+ * prototype and entered at its header, after any nested in it, so the
+ * numbers wait on a stack in between.
+ */
+struct cgsite {
+	const wchar_t *name;	/* of a function, or of a call's callee */
+	long line;
+	long at;		/* among like sites on its line, from 1 */
+	long proc;		/* the function a site is in */
+	long prof;		/* a function's profprocs entry, or -1 */
+	int inl;		/* a function has a body to inline */
+	int task;		/* a call is a समवर्ती spawn */
+};
+static struct cgsite *cgprocs, *cgloops, *cgcalls, *cgconds;
+static size_t ncgprocs, ncgloops, ncgcalls, ncgconds;
+static size_t cgproccap, cgloopcap, cgcallcap, cgcondcap;
+static long *cgprotos, cgproc;
+static size_t ncgprotos, cgprotocap;
+static int cghint = -1;	/* the open condition's hint, or -1 */
+
+/*
+ * Memoized procedures (--memo), whose caches are written after the
+ * program: the globals in each one's key, and which it writes.
+ */
+struct cgmemo {
+	HashNode *id;
+	long nparams;
+	HashNode *vars[MEMO_KEYS];
+	int out[MEMO_KEYS];
+	long nvars;
+};
+static struct cgmemo *cgmemos;
+static size_t ncgmemos, cgmemocap;
+static int cgtasking;		/* tasks may call them from other threads */
+
+static void
+heldgrow(size_t n)
+{
+
+    if (heldcap - heldlen >= n)
+        return;
+    while (heldcap - heldlen < n)
+        heldcap = heldcap ? heldcap * 2 : 4096;
+    if ((held = realloc(held, heldcap * sizeof(wchar_t))) == NULL)
+        error("malloc failed");
+}
+
+/*
+ * Fixed text and names, most of what is held, are copied rather than
+ * run through vswprintf.  Returns 0 for anything else.
+ */
+static int
+heldcopy(const wchar_t *fmt, va_list ap)
+{
+    wchar_t digits[24];
+    const char *s;
+    unsigned long u;
+    size_t i, n;
+    long v;
+
+    if (wcschr(fmt, L'%') == NULL) {
+        n = wcslen(fmt);
+        heldgrow(n);
+        wmemcpy(held + heldlen, fmt, n);
+        heldlen += n;
+        return 1;
+    }
+    if (!wcscmp(fmt, L"%ld")) {
+        v = va_arg(ap, long);
+        u = v < 0 ? -(unsigned long) v : (unsigned long) v;
+        i = n = sizeof(digits) / sizeof(*digits);
+        do
+            digits[--i] = L'0' + u % 10;
+        while ((u /= 10) != 0);
+        if (v < 0)
+            digits[--i] = L'-';
+        heldgrow(n - i);
+        wmemcpy(held + heldlen, digits + i, n - i);
+        heldlen += n - i;
+        return 1;
+    }
+    if (wcscmp(fmt, L"%s") != 0)
+        return 0;
+
+    s = va_arg(ap, const char *);
+    for (n = 0; s[n] != '\0'; n++) {
+        if ((unsigned char) s[n] >= 0x80)
+            return 0;
+    }
+    heldgrow(n);
+    for (i = 0; i < n; i++)
+        held[heldlen++] = (unsigned char) s[i];
+    return 1;
+}
+
+static void
+aout(const wchar_t *fmt, ...)
+{
+    va_list ap, cp;
+    int n, ph = enter(PH_EMIT);
+
+    va_start(ap, fmt);
+    if (cgpending == 0) {
+        if ((n = vwprintf(fmt, ap)) > 0)
+            stats.emitted += n;
+        va_end(ap);
+        enter(ph);
+        return;
+    }
+
+    va_copy(cp, ap);
+    n = heldcopy(fmt, cp);
+    va_end(cp);
+    if (n) {
+        va_end(ap);
+        enter(ph);
+        return;
+    }
+
+    for (;;) {
+        heldgrow(256);
+        va_copy(cp, ap);
+        n = vswprintf(held + heldlen, heldcap - heldlen, fmt, cp);
+        va_end(cp);
+        if (n >= 0)
+            break;
+        heldgrow(heldcap * 2);
+    }
+    heldlen += n;
+    va_end(ap);
+    enter(ph);
+}
+
+static void
+cg_flush(void)
+{
+	struct cgslot *t;
+	size_t i, pos = 0;
+	int ph = enter(PH_EMIT);
+
+	/* The generated C is ASCII, so characters are bytes. */
+	for (i = 0; i < ncgslots; i++) {
+		t = &cgslots[i];
+		wprintf(L"%.*ls", (int) (t->at - pos), held + pos);
+		if (t->len > 0)
+			wprintf(L"%.*ls", (int) t->len, t->text);
+		free(t->text);
+		stats.emitted += t->at - pos + t->len;
+		pos = t->at;
+	}
+	wprintf(L"%.*ls", (int) (heldlen - pos), held + pos);
+	stats.emitted += heldlen - pos;
+
+	heldlen = 0;
+	cgbase += ncgslots;
+	ncgslots = 0;
+	enter(ph);
+}
+
+static struct cgslot *
+slotat(long id)
+{
+
+	return &cgslots[id - cgbase];
+}
+
+/*
+ * Open slot id here; the parser numbers slots the same way.
+ */
+static void
+cg_slot(long id)
+{
+	struct cgslot *t;
+
+	IR_HOOK(CG_SLOT, id, 0);
+
+	if (ncgslots == cgslotcap) {
+		cgslotcap = cgslotcap ? cgslotcap * 2 : 64;
+		cgslots = realloc(cgslots, cgslotcap * sizeof(*cgslots));
+		if (cgslots == NULL)
+			error("malloc failed");
+	}
+	if ((size_t) id != cgbase + ncgslots)
+		error("slot %ld out of order", id);
+
+	++cgpending;
+	t = &cgslots[ncgslots++];
+	t->at = heldlen;
+	t->text = NULL;
+	t->len = t->cap = 0;
+	t->open = 1;
+	t->end = -1;
+}
+
+static void
+slotout(long id, const wchar_t *fmt, ...)
+{
+	struct cgslot *t = slotat(id);
+	va_list ap;
+	int n = 0, ph = enter(PH_EMIT);
+
+	for (;;) {
+		if (t->cap - t->len < 128 || n < 0) {
+			t->cap = t->cap ? t->cap * 2 : 128;
+			t->text = realloc(t->text, t->cap * sizeof(wchar_t));
+			if (t->text == NULL)
+				error("malloc failed");
+		}
+		va_start(ap, fmt);
+		n = vswprintf(t->text + t->len, t->cap - t->len, fmt, ap);
+		va_end(ap);
+		if (n >= 0)
+			break;
+	}
+	t->len += n;
+	enter(ph);
+}
+
+/*
+ * Close a slot, keeping its text or not.
+ */
+static void
+cg_close(long id, int keep)
+{
+	IR_HOOK(CG_CLOSE, id, keep);
+
+	if (!keep)
+		slotat(id)->len = 0;
+	slotat(id)->open = 0;
+	if (--cgpending == 0)
+		cg_flush();
+}
+
+/*
+ * Common subexpressions.  The first copy of one runs from slot a to slot
+ * b, which opens here; its value is __e<a>.
+ */
+static void
+cg_csecopy(long b, long a)
+{
+	IR_HOOK(CG_CSECOPY, b, a);
+
+	cg_slot(b);
+	slotat(a)->end = b;
+}
+
+/*
+ * Take the output from slot a to its end slot, with the text of the
+ * slots in between, out of the held output, into slot into unless that
+ * is -1.
+ */
+static void
+cutspan(long a, long into)
+{
+	struct cgslot *s, *t;
+	size_t i, pos, n;
+
+	s = slotat(a);
+	pos = s->at;
+	for (i = a - cgbase + 1; i < (size_t) (s->end - cgbase); i++) {
+		t = &cgslots[i];
+		if (t->open)
+			error("slot %ld still open in moved output",
+			    (long) (cgbase + i));
+		if (into >= 0)
+			slotout(into, L"%.*ls%.*ls", (int) (t->at - pos),
+			    held + pos, (int) t->len, t->text);
+		pos = t->at;
+		t->at = s->at;
+		t->len = 0;
+	}
+	t = slotat(s->end);
+	if (into >= 0)
+		slotout(into, L"%.*ls", (int) (t->at - pos), held + pos);
+
+	n = t->at - s->at;
+	(void) wmemmove(held + s->at, held + t->at, heldlen - t->at);
+	heldlen -= n;
+	for (i = s->end - cgbase; i < ncgslots; i++)
+		cgslots[i].at -= n;
+}
+
+/*
+ * Move the first copy from slot a into slot decl, to be computed ahead
+ * of the statement, leaving its temporary in its place.
+ */
+static void
+cg_csehoist(long a, long decl)
+{
+	IR_HOOK(CG_CSEHOIST, a, decl);
+
+	slotout(decl, L"long __e%ld=", a);
+	cutspan(a, decl);
+	slotout(decl, L";");
+	slotout(a, L"__e%ld", a);
+}
+
+/*
+ * Replace the copy from slot at on with the value of slot a.
+ */
+static void
+cg_cseuse(long at, long a)
+{
+	struct cgslot *s;
+	size_t i;
+
+	IR_HOOK(CG_CSEUSE, at, a);
+
+	s = slotat(at);
+	for (i = at - cgbase + 1; i < ncgslots; i++) {
+		if (cgslots[i].open)
+			error("slot %ld still open in dropped output",
+			    (long) (cgbase + i));
+		cgslots[i].at = s->at;
+		cgslots[i].len = 0;
+	}
+	heldlen = s->at;
+	slotout(at, L"__e%ld", a);
+	cg_close(at, 1);
+}
+
+/*
+ * The value of slot a was used again: keep it in a temporary.
+ */
+static void
+cg_csetemp(long a, long decl)
+{
+	IR_HOOK(CG_CSETEMP, a, decl);
+
+	slotout(a, L"__e%ld=", a);
+	slotout(decl, L"long __e%ld;", a);
+}
+
+/*
+ * A condition that ranges may yet prove constant runs from slot a to
+ * slot b, which opens here.
+ */
+static void
+cg_condend(long b, long a)
+{
+	IR_HOOK(CG_CONDEND, b, a);
+
+	cg_slot(b);
+	slotat(a)->end = b;
+}
+
+/*
+ * The condition from slot a is proved to be v.
+ */
+static void
+cg_fold(long a, long v)
+{
+	IR_HOOK(CG_FOLD, a, v);
+
+	cutspan(a, -1);
+	slotout(a, L"%ld", v);
+}
+
+/*
+ * Number a profiled site, at the current line.  Sites come in the order
+ * of their lines, so those sharing its line are the last ones.
+ */
+static long
+cg_site(struct cgsite **v, size_t *n, size_t *cap, const wchar_t *name,
+    long proc, int task)
+{
+	size_t i;
+	long at = 1;
+
+	if (*n == *cap) {
+		*cap = *cap ? *cap * 2 : 16;
+		if ((*v = realloc(*v, *cap * sizeof(**v))) == NULL)
+			error("malloc failed");
+	}
+	for (i = *n; i-- > 0 && (*v)[i].line == (long) line; ) {
+		if ((*v)[i].proc == proc && (*v)[i].task == task)
+			at++;
+	}
+	(*v)[*n].name = name;
+	(*v)[*n].line = line;
+	(*v)[*n].at = at;
+	(*v)[*n].proc = proc;
+	(*v)[*n].prof = -1;
+	(*v)[*n].inl = 0;
+	(*v)[*n].task = task;
+	return (*n)++;
+}
+
+static long
+cg_loopsite(void)
+{
+
+	return cg_site(&cgloops, &ncgloops, &cgloopcap, NULL, cgproc, 0);
+}
+
+/*
+ * The profiled procedure of this name nearest the current line, or -1.
+ */
+static long
+prof_proc(const wchar_t *name)
+{
+	size_t i;
+	long best = -1, d;
+
+	for (i = 0; i < nprofprocs; i++) {
+		if (wcscmp(profprocs[i].name, name) != 0)
+			continue;
+		d = profprocs[i].line - (long) line;
+		if (best == -1 ||
+		    labs(d) < labs(profprocs[best].line - (long) line))
+			best = i;
+	}
+	return best;
+}
+
+/*
+ * What the profile counted at the site of kind that is at'th on the
+ * current line of the current function, a call only to callee if not
+ * NULL.  Returns the count, and how often a condition held, in percent,
+ * in *taken.
+ */
+static unsigned long
+prof_site(int kind, const wchar_t *callee, long at, double *taken)
+{
+	struct profsite *s;
+	unsigned long n = 0;
+	double t = 0;
+	size_t lo, hi, mid;
+	long pp, off;
+
+	if (ncgprocs == 0 || (pp = cgprocs[cgproc].prof) == -1)
+		return 0;
+	off = line - cgprocs[cgproc].line;
+
+	lo = 0;
+	hi = nprofsites;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		s = &profsites[mid];
+		if (s->proc < pp || (s->proc == pp && s->off < off))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (s = &profsites[lo]; s < profsites + nprofsites &&
+	    s->proc == pp && s->off == off; s++) {
+		if (s->kind != kind || s->at != at ||
+		    (callee != NULL && wcscmp(s->callee, callee) != 0))
+			continue;
+		n += s->count;
+		t += s->taken * s->count;
+	}
+	if (taken != NULL)
+		*taken = n ? t / n : 0;
+	return n;
+}
+
+/*
+ * Whether a top-level procedure of this name has a body to inline.
+ */
+static int
+cg_inlined(const wchar_t *name)
+{
+	size_t i;
+
+	for (i = 0; i < ncgprocs; i++) {
+		if (cgprocs[i].inl && !wcscmp(cgprocs[i].name, name))
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * Open a condition: count it (-p), and hint the way the profile says it
+ * nearly always goes (--profile-use).  cg_endcond closes what it opened.
+ */
+static void
+cg_condsite(void)
+{
+	double taken;
+	long k = 0;
+
+	if (profiling || profusing)
+		k = cg_site(&cgconds, &ncgconds, &cgcondcap, NULL, cgproc, 0);
+	cghint = -1;
+	if (profusing &&
+	    prof_site('i', NULL, cgconds[k].at, &taken) >= PROF_TESTS) {
+		if (taken >= PROF_SURE)
+			cghint = 1;
+		else if (taken <= 100 - PROF_SURE)
+			cghint = 0;
+	}
+	if (cghint != -1)
+		aout(L"__builtin_expect(!!(");
+	if (profiling)
+		aout(L"__pcond(&__pconds[%ld],", k);
+}
+
+static void
+cg_endcond(void)
+{
+
+	if (profiling)
+		aout(L")");
+	if (cghint != -1)
+		aout(L"),%d)", cghint);
+	cghint = -1;
+}
+
+static void cg_report(void);
+static void cg_memos(void);
+
+static void
+cg_end(void)
+{
+	IR_HOOK(CG_END, 0, 0);
+
+	if (ncgmemos > 0)
+		cg_memos();
+	if (profiling)
+		cg_report();
 	aout(L"\n/* PL/0 compiler %s */\n", PL0C_VERSION);
 }
 
 static void
-cg_const(void)
+cg_const(void)
+{
+	IR_HOOK(CG_CONST, 0, 0);
+
+	aout(L"const long %s=", tokid->value);
+}
+
+static void
+cg_semicolon(void)
+{
+	IR_HOOK(CG_SEMICOLON, 0, 0);
+
+	aout(L";\n");
+}
+
+static void
+cg_symbol(void)
+{
+	IR_HOOK(CG_SYMBOL, 0, 0);
+
+	switch (type) {
+	case TOK_IDENT:
+		aout(L"%s", tokid->value);
+		break;
+	case TOK_NUMBER:
+		aout(L"%ld", tokval);
+		break;
+	case TOK_BEGIN:
+		aout(L"{");
+		break;
+	case TOK_END:
+		aout(L";}\n");
+		break;
+	case TOK_IF:
+		aout(L"if(");
+		cg_condsite();
+		break;
+	case TOK_THEN:
+	case TOK_DO:
+		cg_endcond();
+		aout(L")");
+		break;
+	case TOK_ODD:
+		aout(L"(");
+		break;
+	case TOK_WHILE:
+		aout(L"while(");
+		if (profiling)
+			aout(L"__ploops[%ld]++,", cg_loopsite());
+		cg_condsite();
+		break;
+	case TOK_EQUAL:
+		aout(L"==");
+		break;
+	case TOK_COMMA:
+		aout(L",");
+		break;
+	case TOK_ASSIGN:
+		aout(L"=");
+		break;
+	case TOK_HASH:
+		aout(L"!=");
+		break;
+	case TOK_LESSTHAN:
+		aout(L"<");
+		break;
+	case TOK_GREATERTHAN:
+		aout(L">");
+		break;
+	case TOK_PLUS:
+		aout(L"+");
+		break;
+	case TOK_MINUS:
+		aout(L"-");
+		break;
+	case TOK_MULTIPLY:
+		aout(L"*");
+		break;
+	case TOK_DIVIDE:
+		aout(L"/");
+		break;
+	case TOK_LPAREN:
+		aout(L"(");
+		break;
+	case TOK_RPAREN:
+		aout(L")");
+	}
+}
+
+static void
+cg_crlf(void)
+{
+	IR_HOOK(CG_CRLF, 0, 0);
+
+	aout(L"\n");
+}
+
+/*
+ * A variable, whose type waits in the slot just before it.
+ */
+static void
+cg_var(HashNode *id)
+{
+	IR_HOOK_ID(CG_VAR, 0, 0, id);
+
+	aout(L"%hs", id->value);
+}
+
+/*
+ * The narrowest C type for the values a variable may hold.
+ */
+static void
+cg_type(long slot, long bits)
+{
+	const wchar_t *name;
+
+	IR_HOOK(CG_TYPE, slot, bits);
+
+	switch (bits) {
+	case 8:
+		name = L"signed char";
+		break;
+	case 16:
+		name = L"short";
+		break;
+	case 32:
+		name = L"int";
+		break;
+	default:
+		name = L"long";
+	}
+	slotout(slot, L"%ls ", name);
+	cg_close(slot, 1);
+}
+
+/*
+ * Arithmetic on a narrowed operand is done in long.
+ */
+static void
+cg_cast(void)
+{
+	IR_HOOK(CG_CAST, 0, 0);
+
+	aout(L"(long)");
+}
+
+static void
+cg_dim(long size)
+{
+	IR_HOOK(CG_DIM, size, 0);
+
+	aout(L"[%ld]", size);
+}
+
+static void
+cg_number(long value)
+{
+	IR_HOOK(CG_NUMBER, value, 0);
+
+	aout(L"%ld", value);
+}
+
+/*
+ * An index goes between two slots holding its bounds check.
+ */
+static void
+cg_index(long open)
+{
+	IR_HOOK(CG_INDEX, open, 0);
+
+	aout(L"[");
+	cg_slot(open);
+	slotout(open, L"__bound(");
+}
+
+static void
+cg_endindex(long close, long size)
+{
+	IR_HOOK(CG_ENDINDEX, close, size);
+
+	cg_slot(close);
+	slotout(close, L",%ld,%ld)", size, (long) line);
+	aout(L"]");
+}
+
+/*
+ * Checked arithmetic folds an expression's operands left to right into
+ * __tN, N its first slot.  Each operator gets a slot with its checked
+ * call and one with the plain operator; the site keeps one of them.
+ */
+static void
+cg_checkbegin(long open)
+{
+	IR_HOOK(CG_CHECKBEGIN, open, 0);
+
+	cg_slot(open);
+	slotout(open, L"({long __t%ld=", open);
+}
+
+static void
+cg_checkop(long op, long open)
+{
+	const wchar_t *name;
+
+	IR_HOOK(CG_CHECKOP, op, open);
+
+	switch (type) {
+	case TOK_PLUS:
+		name = L"add";
+		break;
+	case TOK_MINUS:
+		name = L"sub";
+		break;
+	case TOK_MULTIPLY:
+		name = L"mul";
+		break;
+	default:
+		name = L"div";
+	}
+
+	cg_slot(op);
+	slotout(op, L";__t%ld=__%ls(__t%ld,", open, name, open);
+	cg_slot(op + 1);
+	slotout(op + 1, L"%lc", (wint_t) type);
+}
+
+static void
+cg_checkline(long close, long at)
+{
+	IR_HOOK(CG_CHECKLINE, close, at);
+
+	cg_slot(close);
+	slotout(close, L",%ld)", at);
+}
+
+static void
+cg_checkend(long open, long any)
+{
+	IR_HOOK(CG_CHECKEND, open, any);
+
+	if (any)
+		aout(L";__t%ld;})", open);
+	cg_close(open, any);
+}
+
+/*
+ * Nested procedures get a number on their name, as different
+ * procedures may nest procedures of the same name.
+ */
+static void
+cg_name(HashNode *id, long num)
+{
+
+	if (num == 0)
+		aout(L"%hs", id->value);
+	else
+		aout(L"%hs_%ld", id->value, num);
+}
+
+static void
+cg_main(void)
+{
+	IR_HOOK(CG_MAIN, 0, 0);
+
+	/*
+	 * The main program's task group is at file scope: one declared in
+	 * main would hold back the whole body until it was known to be used.
+	 */
+	aout(L"void __spawn(long *, void (*)(long *), const long *, unsigned long);\n");
+	aout(L"void __join(long *);\n");
+	aout(L"long __tasks;\n\n");
+	if (ncgmemos > 0)
+		aout(L"static void __mreport(void);\n\n");
+	aout(L"int\n");
+	aout(L"main(int argc, char *argv[])\n");
+	aout(L"{\n");
+	if (!freestanding)
+		aout(L"    setlocale(LC_ALL, \"en_US.UTF-8\");\n");
+	if (ncgmemos > 0)
+		aout(L"    atexit(__mreport);\n");
+	if (profiling || profusing) {
+		cgproc = cg_site(&cgprocs, &ncgprocs, &cgproccap,
+		    L"(मुख्य)", 0, 0);
+		if (profusing)
+			cgprocs[cgproc].prof = prof_proc(L"(मुख्य)");
+	}
+	if (profiling) {
+		aout(L"    __pstart();\n");
+		aout(L"    __PENTER(%ld);\n", cgproc);
+	}
+}
+
+/*
+ * A procedure's attributes from the profile: hot, cold, or neither.  One
+ * hot at any call site gets its body as a static inline function of its
+ * own, for those sites to call, and the function every other caller
+ * calls is a wrapper around it.  Only a top-level procedure, whose
+ * prototype lifts nothing, can have one.
+ */
+static void
+cg_profproto(long k, HashNode *id, long num, long nparams)
+{
+	struct profproc *p;
+	const wchar_t *attr = L"";
+	size_t i;
+	long j;
+
+	if ((cgprocs[k].prof = prof_proc(id->key)) == -1)
+		return;
+	p = &profprocs[cgprocs[k].prof];
+	if (p->calls == 0)
+		attr = L"__attribute__((cold)) ";
+	else if (p->calls >= PROF_HOT || p->total >= PROF_HOTPCT)
+		attr = L"__attribute__((hot)) ";
+
+	for (i = 0; num == 0 && i < nprofsites; i++) {
+		if (profsites[i].kind == 'c' &&
+		    profsites[i].count >= PROF_HOT &&
+		    !wcscmp(profsites[i].callee, id->key)) {
+			cgprocs[k].inl = 1;
+			break;
+		}
+	}
+	if (cgprocs[k].inl) {
+		aout(L"static inline %lslong %hs__in(", attr, id->value);
+		for (j = 0; j < nparams; j++)
+			aout(j ? L", long" : L"long");
+		aout(L");\n");
+		aout(L"%lslong\n%hs(", attr, id->value);
+		for (j = 0; j < nparams; j++)
+			aout(j ? L", long __a%ld" : L"long __a%ld", j);
+		aout(L")\n{\n    return %hs__in(", id->value);
+		for (j = 0; j < nparams; j++)
+			aout(j ? L", __a%ld" : L"__a%ld", j);
+		aout(L");\n}\n\n");
+	}
+	aout(L"%ls", attr);
+}
+
+static void
+cg_prototype(HashNode *id, long num, long nparams)
+{
+	long i, k;
+
+	IR_HOOK_ID(CG_PROTOTYPE, num, nparams, id);
+
+	if (profiling || profusing) {
+		if (ncgprotos == cgprotocap) {
+			cgprotocap = cgprotocap ? cgprotocap * 2 : 16;
+			cgprotos = realloc(cgprotos,
+			    cgprotocap * sizeof(*cgprotos));
+			if (cgprotos == NULL)
+				error("malloc failed");
+		}
+		k = cg_site(&cgprocs, &ncgprocs, &cgproccap, id->key, 0, 0);
+		cgprotos[ncgprotos++] = k;
+		if (profusing)
+			cg_profproto(k, id, num, nparams);
+	}
+
+	aout(L"long ");
+	cg_name(id, num);
+	aout(L"(");
+	for (i = 0; i < nparams; i++)
+		aout(i ? L", long" : L"long");
+}
+
+static void
+cg_endproto(void)
+{
+	IR_HOOK(CG_ENDPROTO, 0, 0);
+
+	aout(L");\n");
+}
+
+static void
+cg_procedure(HashNode *id, long num)
+{
+	IR_HOOK_ID(CG_PROCEDURE, num, 0, id);
+
+	if (profiling || profusing)
+		cgproc = cgprotos[--ncgprotos];
+	if (profusing && cgprocs[cgproc].inl) {
+		aout(L"static inline long\n%hs__in(", id->value);
+		return;
+	}
+	aout(L"long\n");
+	cg_name(id, num);
+	aout(L"(");
+}
+
+static void
+cg_param(HashNode *id, long i)
+{
+	IR_HOOK_ID(CG_PARAM, i, 0, id);
+
+	aout(i ? L", long %hs" : L"long %hs", id->value);
+}
+
+static void
+cg_endheader(void)
+{
+	IR_HOOK(CG_ENDHEADER, 0, 0);
+
+	aout(L")\n{\n");
+	if (profiling)
+		aout(L"__PENTER(%ld);\n", cgproc);
+}
+
+static void
+cg_epilogue(long join)
+{
+	IR_HOOK(CG_EPILOGUE, join, 0);
+
+	if (join)
+		aout(L";__join(&__tasks)");
+	aout(L";return 0;\n}\n");
+}
+
+/*
+ * Spell a lifted variable into a slot.
+ */
+static void
+cg_lift(long slot, int how, HashNode *id)
+{
+	IR_HOOK_ID(CG_LIFT, slot, how, id);
+
+	if (how & LIFT_COMMA)
+		slotout(slot, L", ");
+	if (how & LIFT_LONG)
+		slotout(slot, L"(long)");
+
+	switch (how & ~(LIFT_COMMA | LIFT_LONG)) {
+	case LIFT_PROTO:
+		slotout(slot, L"long *");
+		break;
+	case LIFT_PARAM:
+		slotout(slot, L"long *%hs", id->value);
+		break;
+	case LIFT_ADDR:
+		slotout(slot, L"&%hs", id->value);
+		break;
+	case LIFT_ARG:
+		slotout(slot, L"%hs", id->value);
+		break;
+	case LIFT_DEFINE:
+		slotout(slot, L"#define %hs (*%hs)\n", id->value, id->value);
+		break;
+	case LIFT_UNDEF:
+		slotout(slot, L"#undef %hs\n", id->value);
+	}
+}
+
+static void
+cg_tail(long slot)
+{
+	IR_HOOK(CG_TAIL, slot, 0);
+
+	slotout(slot, L"__tail:;\n");
+}
+
+static void
+cg_return(void)
+{
+	IR_HOOK(CG_RETURN, 0, 0);
+
+	aout(L"return ");
+}
+
+/*
+ * A self call in a लौटाओ evaluates its arguments into temporaries, then
+ * either jumps back to the top or makes an ordinary call with them.
+ */
+static void
+cg_temp(long i)
+{
+	IR_HOOK(CG_TEMP, i, 0);
+
+	if (i == 0)
+		aout(L"{long __a0=");
+	else
+		aout(L",__a%ld=", i);
+}
+
+static void
+cg_endtemps(long n)
+{
+	IR_HOOK(CG_ENDTEMPS, n, 0);
+
+	aout(n ? L";" : L"{");
+}
+
+static void
+cg_reassign(HashNode *id, long i)
+{
+	IR_HOOK_ID(CG_REASSIGN, i, 0, id);
+
+	aout(L"%hs=__a%ld;", id->value, i);
+}
+
+static void
+cg_goto(void)
+{
+	IR_HOOK(CG_GOTO, 0, 0);
+
+	aout(L"goto __tail;}");
+}
+
+static void
+cg_usetemps(long n)
+{
+	long i;
+
+	IR_HOOK(CG_USETEMPS, n, 0);
+
+	for (i = 0; i < n; i++)
+		aout(i ? L",__a%ld" : L"__a%ld", i);
+}
+
+static void
+cg_endself(void)
+{
+	IR_HOOK(CG_ENDSELF, 0, 0);
+
+	aout(L";}");
+}
+
+static void
+cg_readchar(void)
+{
+	IR_HOOK(CG_READCHAR, 0, 0);
+
+	if (freestanding) {
+		aout(L"%s = __readchar();\n", tokid->value);
+		return;
+	}
+    aout(L"wint_t __wch = fgetwc(stdin);\n");
+    aout(L"if (__wch == WEOF) {\n");
+    aout(L"    /* treat EOF as -1 or handle error */\n");
+    aout(L"    (void) fprintf(stderr, \"unexpected EOF when reading character\\n\");\n");
+    aout(L"    exit(1);\n");
+    aout(L"}\n");
+    aout(L"%s = (long) __wch;\n", tokid->value);
+}
+
+/*
+ * A समानांतर loop: its bounds are evaluated in place, and its body is
+ * diverted into a function of its own, run by __parfor over chunks of
+ * the range.  Variables other than globals reach the body through a
+ * context array of pointers.
+ */
+static void
+cg_parbegin(long num)
+{
+	IR_HOOK(CG_PARBEGIN, num, 0);
+
+	aout(L"{void __par%ld(long **,long,long,int);\n", num);
+	aout(L"void __parfor(void (*)(long **,long,long,int),long **,long,long);\n");
+	aout(L"long __lo%ld=", num);
+}
+
+static void
+cg_parto(long num)
+{
+	IR_HOOK(CG_PARTO, num, 0);
+
+	aout(L",__hi%ld=", num);
+}
+
+static void
+cg_parbody(long num, long divert)
+{
+	IR_HOOK(CG_PARBODY, num, divert);
+
+	aout(L";\n");
+	if (profiling)
+		aout(L"__ploops[%ld]+=__lo%ld<=__hi%ld?"
+		    "(unsigned long)__hi%ld-(unsigned long)__lo%ld+1:0;\n",
+		    cg_loopsite(), num, num, num, num);
+	cg_slot(divert);
+	divertat = heldlen;
+
+	aout(L"void\n");
+	aout(L"__par%ld(long **__c, long __lo, long __hi, int __last)\n", num);
+	aout(L"{\n");
+}
+
+static void
+cg_parloop(HashNode *id)
+{
+	IR_HOOK_ID(CG_PARLOOP, 0, 0, id);
+
+	aout(L"for(%hs=__lo;%hs<=__hi;%hs++){\n", id->value, id->value,
+	    id->value);
+}
+
+static void
+cg_parend(void)
+{
+	IR_HOOK(CG_PAREND, 0, 0);
+
+	aout(L";}\n");
+}
+
+/*
+ * Declare a variable of the body; how and its context index k share
+ * the second argument.
+ */
+static void
+cg_pardecl(long slot, long how, HashNode *id)
+{
+	IR_HOOK_ID(CG_PARDECL, slot, how, id);
+
+	switch (how & 7) {
+	case DECL_LOCAL:
+		slotout(slot, L"long %hs;\n", id->value);
+		break;
+	case DECL_ZERO:
+		slotout(slot, L"long %hs=0;\n", id->value);
+		break;
+	case DECL_SHARED:
+		slotout(slot, L"#define %hs (*__c[%ld])\n", id->value, how >> 3);
+		break;
+	case DECL_ARRAY:
+		slotout(slot, L"#define %hs (__c[%ld])\n", id->value, how >> 3);
+	}
+}
+
+/*
+ * Add a chunk's partial sum into reduction k.  Under -C (at is the line
+ * of the loop, else 0) the sum of the partials traps on overflow too.
+ */
+static void
+cg_parreduce(long k, long at, HashNode *id)
+{
+	IR_HOOK_ID(CG_PARREDUCE, k, at, id);
+
+	if (at == 0) {
+		aout(L"__atomic_fetch_add(__c[%ld],%hs,__ATOMIC_RELAXED);\n", k,
+		    id->value);
+		return;
+	}
+	aout(L"{long __o=__atomic_load_n(__c[%ld],__ATOMIC_RELAXED),__n;"
+	    L"do{if(__builtin_add_overflow(__o,%hs,&__n))"
+	    L"__trap(%ld,\"overflow\");}"
+	    L"while(!__atomic_compare_exchange_n(__c[%ld],&__o,__n,1,"
+	    L"__ATOMIC_RELAXED,__ATOMIC_RELAXED));}\n", k, id->value, at, k);
+}
+
+static void
+cg_parlast(long k, HashNode *id)
+{
+	IR_HOOK_ID(CG_PARLAST, k, 0, id);
+
+	aout(L"if(__last)*__c[%ld]=%hs;\n", k, id->value);
+}
+
+static void
+cg_parundef(HashNode *id)
+{
+	IR_HOOK_ID(CG_PARUNDEF, 0, 0, id);
+
+	aout(L"#undef %hs\n", id->value);
+}
+
+static void
+wappend(struct wbuf *b, const wchar_t *p, size_t n)
+{
+
+	if (b->cap - b->len < n) {
+		while (b->cap - b->len < n)
+			b->cap = b->cap ? b->cap * 2 : 4096;
+		if ((b->p = realloc(b->p, b->cap * sizeof(wchar_t))) == NULL)
+			error("malloc failed");
+	}
+	wmemcpy(b->p + b->len, p, n);
+	b->len += n;
+}
+
+/*
+ * Whether any slot after slot first is still open.
+ */
+static int
+slotsopen(long first)
+{
+	size_t i;
+
+	for (i = first - cgbase + 1; i < ncgslots; i++) {
+		if (cgslots[i].open)
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Move the held output from pos on, with the text of the slots in it
+ * after slot first, to the end of b.  The slots stay behind at pos,
+ * empty; each must be closed.
+ */
+static void
+cutheld(struct wbuf *b, size_t pos, long first)
+{
+	struct cgslot *t;
+	size_t i, at = pos;
+
+	for (i = first - cgbase + 1; i < ncgslots; i++) {
+		t = &cgslots[i];
+		if (t->open)
+			error("slot %ld still open in moved output",
+			    (long) (cgbase + i));
+		wappend(b, held + pos, t->at - pos);
+		wappend(b, t->text, t->len);
+		pos = t->at;
+		t->at = at;
+		t->len = 0;
+	}
+	wappend(b, held + pos, heldlen - pos);
+	heldlen = at;
+}
+
+/*
+ * Move the body, and the slots in it, out of the held output.
+ */
+static void
+cg_enddivert(long divert)
+{
+	IR_HOOK(CG_ENDDIVERT, divert, 0);
+
+	aout(L"}\n\n");
+	cutheld(&outlined, divertat, divert);
+	cg_close(divert, 1);
+}
+
+static void
+cg_parctx(long num)
+{
+	IR_HOOK(CG_PARCTX, num, 0);
+
+	aout(L"long *__c%ld[]={", num);
+}
+
+static void
+cg_ctxarg(int scalar, HashNode *id)
+{
+	IR_HOOK_ID(CG_CTXARG, scalar, 0, id);
+
+	aout(scalar ? L"&%hs," : L"%hs,", id->value);
+}
+
+static void
+cg_parrun(long num, HashNode *id)
+{
+	IR_HOOK_ID(CG_PARRUN, num, 0, id);
+
+	aout(L"0};\n");
+	aout(L"__parfor(__par%ld,__c%ld,__lo%ld,__hi%ld);\n", num, num, num,
+	    num);
+	aout(L"%hs=__lo%ld>__hi%ld?__lo%ld:__hi%ld+1;}", id->value, num, num,
+	    num, num);
+}
+
+/*
+ * After a function, the समानांतर bodies diverted out of it, preceded the
+ * first time by the thread pool they run on.  HINDIPL0_THREADS sets the
+ * number of threads, and HINDIPL0_SCHEDULE=static splits the range into
+ * one even block per thread instead of handing out small chunks.  A loop
+ * reached while the pool is busy, from a समवर्ती task, runs in place.
+ */
+static void
+cg_outlined(void)
+{
+	IR_HOOK(CG_OUTLINED, 0, 0);
+
+	if (outlined.len == 0)
+		return;
+
+	if (!parruntime && freestanding) {
+		parruntime = 1;
+		aout(L"typedef void (*__parbody)(long **, long, long, int);\n\n");
+		aout(L"/* Without threads (--freestanding), the loop runs in place. */\n");
+		aout(L"void\n");
+		aout(L"__parfor(__parbody fn, long **ctx, long lo, long hi)\n");
+		aout(L"{\n");
+		aout(L"    if (lo <= hi)\n");
+		aout(L"        fn(ctx, lo, hi, 1);\n");
+		aout(L"}\n\n");
+	}
+	if (!parruntime) {
+		parruntime = 1;
+		aout(L"#include <pthread.h>\n");
+		aout(L"#include <string.h>\n");
+		aout(L"#include <unistd.h>\n\n");
+		aout(L"typedef void (*__parbody)(long **, long, long, int);\n\n");
+		aout(L"static struct {\n");
+		aout(L"    pthread_mutex_t lock;\n");
+		aout(L"    pthread_cond_t work, done;\n");
+		aout(L"    int dynamic, busy, active;\n");
+		aout(L"    unsigned long nthreads, gen, n, chunk, next;\n");
+		aout(L"    __parbody fn;\n");
+		aout(L"    long **ctx;\n");
+		aout(L"    long lo;\n");
+		aout(L"} __pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };\n\n");
+		aout(L"static void\n");
+		aout(L"__parrun(unsigned long self)\n");
+		aout(L"{\n");
+		aout(L"    unsigned long a, b, t = __pool.nthreads, n = __pool.n;\n\n");
+		aout(L"    if (!__pool.dynamic) {\n");
+		aout(L"        a = n / t * self + (self < n %% t ? self : n %% t);\n");
+		aout(L"        b = a + n / t + (self < n %% t);\n");
+		aout(L"        if (a < b)\n");
+		aout(L"            __pool.fn(__pool.ctx, __pool.lo + (long) a, __pool.lo + (long) (b - 1), b == n);\n");
+		aout(L"        return;\n");
+		aout(L"    }\n");
+		aout(L"    while ((a = __atomic_fetch_add(&__pool.next, __pool.chunk, __ATOMIC_RELAXED)) < n) {\n");
+		aout(L"        b = n - a < __pool.chunk ? n : a + __pool.chunk;\n");
+		aout(L"        __pool.fn(__pool.ctx, __pool.lo + (long) a, __pool.lo + (long) (b - 1), b == n);\n");
+		aout(L"    }\n");
+		aout(L"}\n\n");
+		aout(L"static void *\n");
+		aout(L"__parworker(void *arg)\n");
+		aout(L"{\n");
+		aout(L"    unsigned long self = (unsigned long) arg, seen = 0;\n\n");
+		if (profiling)
+			aout(L"    __pjoin();\n");
+		aout(L"    for (;;) {\n");
+		aout(L"        pthread_mutex_lock(&__pool.lock);\n");
+		aout(L"        while (__pool.gen == seen)\n");
+		aout(L"            pthread_cond_wait(&__pool.work, &__pool.lock);\n");
+		aout(L"        seen = __pool.gen;\n");
+		aout(L"        pthread_mutex_unlock(&__pool.lock);\n");
+		aout(L"        __parrun(self);\n");
+		aout(L"        pthread_mutex_lock(&__pool.lock);\n");
+		aout(L"        if (--__pool.busy == 0)\n");
+		aout(L"            pthread_cond_signal(&__pool.done);\n");
+		aout(L"        pthread_mutex_unlock(&__pool.lock);\n");
+		aout(L"    }\n");
+		aout(L"    return NULL;\n");
+		aout(L"}\n\n");
+		aout(L"void\n");
+		aout(L"__parfor(__parbody fn, long **ctx, long lo, long hi)\n");
+		aout(L"{\n");
+		aout(L"    static int started;\n");
+		aout(L"    pthread_t t;\n");
+		aout(L"    unsigned long i;\n");
+		aout(L"    char *s;\n");
+		aout(L"    long n;\n\n");
+		aout(L"    if (lo > hi)\n");
+		aout(L"        return;\n");
+		aout(L"    if (__atomic_exchange_n(&__pool.active, 1, __ATOMIC_ACQUIRE)) {\n");
+		aout(L"        fn(ctx, lo, hi, 1);\n");
+		aout(L"        return;\n");
+		aout(L"    }\n");
+		aout(L"    if (!started) {\n");
+		aout(L"        started = 1;\n");
+		aout(L"        n = (s = getenv(\"HINDIPL0_THREADS\")) != NULL ? atol(s) : 0;\n");
+		aout(L"        if (n <= 0)\n");
+		aout(L"            n = sysconf(_SC_NPROCESSORS_ONLN);\n");
+		aout(L"        __pool.nthreads = n < 1 ? 1 : n > 256 ? 256 : n;\n");
+		aout(L"        s = getenv(\"HINDIPL0_SCHEDULE\");\n");
+		aout(L"        __pool.dynamic = s == NULL || strcmp(s, \"static\") != 0;\n");
+		aout(L"        for (i = 1; i < __pool.nthreads; i++) {\n");
+		aout(L"            if (pthread_create(&t, NULL, __parworker, (void *) i) != 0)\n");
+		aout(L"                break;\n");
+		aout(L"            pthread_detach(t);\n");
+		aout(L"        }\n");
+		aout(L"        __pool.nthreads = i;\n");
+		aout(L"    }\n\n");
+		aout(L"    __pool.fn = fn;\n");
+		aout(L"    __pool.ctx = ctx;\n");
+		aout(L"    __pool.lo = lo;\n");
+		aout(L"    __pool.n = (unsigned long) hi - (unsigned long) lo + 1;\n");
+		aout(L"    __pool.chunk = __pool.n / (8 * __pool.nthreads);\n");
+		aout(L"    if (__pool.chunk == 0)\n");
+		aout(L"        __pool.chunk = 1;\n");
+		aout(L"    __pool.next = 0;\n");
+		aout(L"    if (__pool.nthreads == 1) {\n");
+		aout(L"        fn(ctx, lo, hi, 1);\n");
+		aout(L"        __atomic_store_n(&__pool.active, 0, __ATOMIC_RELEASE);\n");
+		aout(L"        return;\n");
+		aout(L"    }\n\n");
+		aout(L"    pthread_mutex_lock(&__pool.lock);\n");
+		aout(L"    __pool.busy = __pool.nthreads - 1;\n");
+		aout(L"    __pool.gen++;\n");
+		aout(L"    pthread_cond_broadcast(&__pool.work);\n");
+		aout(L"    pthread_mutex_unlock(&__pool.lock);\n");
+		aout(L"    __parrun(0);\n");
+		aout(L"    pthread_mutex_lock(&__pool.lock);\n");
+		aout(L"    while (__pool.busy > 0)\n");
+		aout(L"        pthread_cond_wait(&__pool.done, &__pool.lock);\n");
+		aout(L"    pthread_mutex_unlock(&__pool.lock);\n");
+		aout(L"    __atomic_store_n(&__pool.active, 0, __ATOMIC_RELEASE);\n");
+		aout(L"}\n\n");
+	}
+
+	aout(L"%.*ls", (int) outlined.len, outlined.p);
+	outlined.len = 0;
+}
+
+/*
+ * A प्रत्येक loop evaluates its bounds once and runs a counter over its
+ * trip count, from which it sets the loop variable; a body that cannot
+ * change the counter leaves a loop the C compiler can vectorize.
+ */
+static void
+cg_forbegin(void)
+{
+	struct cgfor *f;
+
+	IR_HOOK(CG_FORBEGIN, 0, 0);
+
+	if (ncgfors == cgforcap) {
+		cgforcap = cgforcap ? cgforcap * 2 : 8;
+		cgfors = realloc(cgfors, cgforcap * sizeof(*cgfors));
+		if (cgfors == NULL)
+			error("malloc failed");
+	}
+	f = &cgfors[ncgfors++];
+	f->num = ++cgnfor;
+	f->hold = -1;
+
+	aout(L"{long __lo%ld=", f->num);
+}
+
+static void
+cg_forto(void)
+{
+	IR_HOOK(CG_FORTO, 0, 0);
+
+	aout(L",__hi%ld=", cgfors[ncgfors - 1].num);
+}
+
+static void
+cg_forbody(HashNode *id, long hold, long step)
+{
+	struct cgfor *f;
+	long n;
+
+	IR_HOOK_ID(CG_FORBODY, hold, step, id);
+
+	f = &cgfors[ncgfors - 1];
+	n = f->num;
+	f->hold = hold;
+	f->step = step;
+	f->id = id;
+
+	if (step > 0)
+		aout(L";unsigned long __n%ld=__lo%ld<=__hi%ld?"
+		    "((unsigned long)__hi%ld-(unsigned long)__lo%ld)/%ld+1:0;\n",
+		    n, n, n, n, n, step);
+	else
+		aout(L";unsigned long __n%ld=__lo%ld>=__hi%ld?"
+		    "((unsigned long)__lo%ld-(unsigned long)__hi%ld)/%ld+1:0;\n",
+		    n, n, n, n, n, -step);
+	if (profiling)
+		aout(L"__ploops[%ld]+=__n%ld;\n", cg_loopsite(), n);
+	cg_slot(hold);
+}
+
+/*
+ * Unrolled, each copy of the body sets the loop variable to a constant.
+ * A body with slots still open cannot be copied yet, and stays a loop.
+ */
+/*
+ * Write f's header into its slot, which lets its body out.
+ */
+static void
+cg_forheader(struct cgfor *f)
+{
+	long n = f->num;
+
+	if (f->hold < 0)
+		return;
+	slotout(f->hold, L"#pragma GCC unroll %d\n", FOR_PARTIAL);
+	slotout(f->hold, L"for(unsigned long __k%ld=0;__k%ld<__n%ld;"
+	    "__k%ld++){%hs=(long)((unsigned long)__lo%ld+__k%ld*%ld);\n",
+	    n, n, n, n, f->id->value, n, n, f->step);
+	cg_close(f->hold, 1);
+	f->hold = -1;
+}
+
+static void
+cg_endfor(HashNode *id, long unroll, long lo)
+{
+	struct cgfor *f;
+	struct wbuf body = { NULL, 0, 0 };
+	long k, n;
+
+	IR_HOOK_ID(CG_ENDFOR, unroll, lo, id);
+
+	f = &cgfors[ncgfors - 1];
+	n = f->num;
+
+	if (unroll > 0 && f->hold >= 0 && !slotsopen(f->hold)) {
+		cutheld(&body, slotat(f->hold)->at, f->hold);
+		for (k = 0; k < unroll; k++) {
+			aout(L"{%hs=%ld;", id->value, lo + k * f->step);
+			aout(L"%.*ls", (int) body.len, body.p);
+			aout(L";}\n");
+		}
+		free(body.p);
+		cg_close(f->hold, 1);
+	} else {
+		cg_forheader(f);
+		aout(L";}\n");
+	}
+	aout(L"%hs=(long)((unsigned long)__lo%ld+__n%ld*%ld);}", id->value,
+	    n, n, f->step);
+
+	ncgfors--;
+}
+
+/*
+ * Every प्रत्येक loop being generated stays a loop, so its body need not
+ * be held any longer.
+ */
+static void
+cg_forkeep(void)
+{
+	size_t i;
+
+	IR_HOOK(CG_FORKEEP, 0, 0);
+
+	for (i = 0; i < ncgfors; i++)
+		cg_forheader(&cgfors[i]);
+}
+
+static void
+cg_call(HashNode *id, long num, long memo)
+{
+	long k = 0;
+
+	IR_HOOK_ID(CG_CALL, num, memo, id);
+
+	if (profiling || profusing)
+		k = cg_site(&cgcalls, &ncgcalls, &cgcallcap, id->key, cgproc, 0);
+	if (profiling)
+		aout(L"(__pcalls[%ld]++,", k);
+	if (memo)
+		aout(L"%hs__memo", id->value);
+	else if (profusing && num == 0 && cg_inlined(id->key) &&
+	    prof_site('c', id->key, cgcalls[k].at, NULL) >= PROF_HOT)
+		aout(L"%hs__in", id->value);
+	else
+		cg_name(id, num);
+	aout(profiling ? L")(" : L"(");
+}
+
+static void
+cg_endcall(void)
+{
+	IR_HOOK(CG_ENDCALL, 0, 0);
+
+	aout(L")");
+}
+
+/*
+ * A समवर्ती call packs its arguments, and the lifted variables after
+ * them, into an array of longs for __spawn to copy.  The leading 0 keeps
+ * the array from being empty.
+ */
+static void
+cg_spawn(HashNode *id, long num)
+{
+	IR_HOOK_ID(CG_SPAWN, num, 0, id);
+
+	aout(L"{");
+	if (profiling)
+		aout(L"__pcalls[%ld]++;", cg_site(&cgcalls, &ncgcalls,
+		    &cgcallcap, id->key, cgproc, 1));
+	aout(L"void __task_");
+	cg_name(id, num);
+	aout(L"(long *);long __a[]={0");
+}
+
+static void
+cg_taskarg(void)
+{
+	IR_HOOK(CG_TASKARG, 0, 0);
+
+	aout(L",");
+}
+
+static void
+cg_endspawn(HashNode *id, long num)
+{
+	IR_HOOK_ID(CG_ENDSPAWN, num, 0, id);
+
+	aout(L"};__spawn(&__tasks,__task_");
+	cg_name(id, num);
+	aout(L",__a,sizeof __a/sizeof *__a);}");
+}
+
+static void
+cg_wait(void)
+{
+	IR_HOOK(CG_WAIT, 0, 0);
+
+	aout(L"__join(&__tasks)");
+}
+
+/*
+ * Join the function's tasks before a लौटाओ, as a statement or as the
+ * left of a comma.
+ */
+static void
+cg_join(long slot, long stmt)
+{
+	IR_HOOK(CG_JOIN, slot, stmt);
+
+	slotout(slot, stmt ? L"__join(&__tasks);" : L"__join(&__tasks),");
+}
+
+static void
+cg_group(long slot)
+{
+	IR_HOOK(CG_GROUP, slot, 0);
+
+	slotout(slot, L"void __spawn(long *, void (*)(long *), const long *, unsigned long);\n");
+	slotout(slot, L"void __join(long *);\n");
+	slotout(slot, L"long __tasks=0;\n");
+}
+
+/*
+ * The task scheduler: a queue of tasks run by HINDIPL0_THREADS - 1
+ * workers, and by any thread joining a group while the queue is not
+ * empty.  A group is a count of its unfinished tasks.
+ */
+static void
+cg_tasks(void)
+{
+	IR_HOOK(CG_TASKS, 0, 0);
+
+	cgtasking = 1;
+	if (freestanding) {
+		aout(L"\n/* Without threads (--freestanding), a task runs as it is spawned. */\n");
+		aout(L"void\n");
+		aout(L"__spawn(long *group, void (*fn)(long *), const long *a, unsigned long n)\n");
+		aout(L"{\n");
+		aout(L"    (void) group;\n");
+		aout(L"    (void) n;\n");
+		aout(L"    fn((long *) a);\n");
+		aout(L"}\n\n");
+		aout(L"void\n");
+		aout(L"__join(long *group)\n");
+		aout(L"{\n");
+		aout(L"    (void) group;\n");
+		aout(L"}\n\n");
+		return;
+	}
+	aout(L"\n#include <pthread.h>\n");
+	aout(L"#include <string.h>\n");
+	aout(L"#include <unistd.h>\n\n");
+	aout(L"struct __task {\n");
+	aout(L"    struct __task *next;\n");
+	aout(L"    void (*fn)(long *);\n");
+	aout(L"    long *group;\n");
+	aout(L"    long a[];\n");
+	aout(L"};\n\n");
+	aout(L"static struct {\n");
+	aout(L"    pthread_mutex_t lock;\n");
+	aout(L"    pthread_cond_t wake;\n");
+	aout(L"    struct __task *head, **tail;\n");
+	aout(L"    int started;\n");
+	aout(L"} __sched = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, &__sched.head };\n\n");
+	aout(L"/* Run the task at the head of the queue; the lock is held around it. */\n");
+	aout(L"static void\n");
+	aout(L"__taskrun(void)\n");
+	aout(L"{\n");
+	aout(L"    struct __task *t = __sched.head;\n\n");
+	aout(L"    if ((__sched.head = t->next) == NULL)\n");
+	aout(L"        __sched.tail = &__sched.head;\n");
+	aout(L"    pthread_mutex_unlock(&__sched.lock);\n");
+	aout(L"    t->fn(t->a);\n");
+	aout(L"    pthread_mutex_lock(&__sched.lock);\n");
+	aout(L"    if (--*t->group == 0)\n");
+	aout(L"        pthread_cond_broadcast(&__sched.wake);\n");
+	aout(L"    free(t);\n");
+	aout(L"}\n\n");
+	aout(L"static void *\n");
+	aout(L"__taskworker(void *arg)\n");
+	aout(L"{\n");
+	aout(L"    (void) arg;\n");
+	if (profiling)
+		aout(L"    __pjoin();\n");
+	aout(L"    pthread_mutex_lock(&__sched.lock);\n");
+	aout(L"    for (;;) {\n");
+	aout(L"        while (__sched.head == NULL)\n");
+	aout(L"            pthread_cond_wait(&__sched.wake, &__sched.lock);\n");
+	aout(L"        __taskrun();\n");
+	aout(L"    }\n");
+	aout(L"    return NULL;\n");
+	aout(L"}\n\n");
+	aout(L"void\n");
+	aout(L"__spawn(long *group, void (*fn)(long *), const long *a, unsigned long n)\n");
+	aout(L"{\n");
+	aout(L"    struct __task *t;\n");
+	aout(L"    pthread_t w;\n");
+	aout(L"    char *s;\n");
+	aout(L"    long i, k;\n\n");
+	aout(L"    if ((t = malloc(sizeof(*t) + n * sizeof(long))) == NULL) {\n");
+	aout(L"        (void) fprintf(stderr, \"out of memory for a task\\n\");\n");
+	aout(L"        exit(1);\n");
+	aout(L"    }\n");
+	aout(L"    t->next = NULL;\n");
+	aout(L"    t->fn = fn;\n");
+	aout(L"    t->group = group;\n");
+	aout(L"    memcpy(t->a, a, n * sizeof(long));\n\n");
+	aout(L"    pthread_mutex_lock(&__sched.lock);\n");
+	aout(L"    if (!__sched.started) {\n");
+	aout(L"        __sched.started = 1;\n");
+	aout(L"        k = (s = getenv(\"HINDIPL0_THREADS\")) != NULL ? atol(s) : 0;\n");
+	aout(L"        if (k <= 0)\n");
+	aout(L"            k = sysconf(_SC_NPROCESSORS_ONLN);\n");
+	aout(L"        for (i = 1; i < k && i < 256; i++) {\n");
+	aout(L"            if (pthread_create(&w, NULL, __taskworker, NULL) != 0)\n");
+	aout(L"                break;\n");
+	aout(L"            pthread_detach(w);\n");
+	aout(L"        }\n");
+	aout(L"    }\n");
+	aout(L"    ++*group;\n");
+	aout(L"    *__sched.tail = t;\n");
+	aout(L"    __sched.tail = &t->next;\n");
+	aout(L"    pthread_cond_broadcast(&__sched.wake);\n");
+	aout(L"    pthread_mutex_unlock(&__sched.lock);\n");
+	aout(L"}\n\n");
+	aout(L"void\n");
+	aout(L"__join(long *group)\n");
+	aout(L"{\n");
+	aout(L"    pthread_mutex_lock(&__sched.lock);\n");
+	aout(L"    while (*group > 0) {\n");
+	aout(L"        if (__sched.head != NULL)\n");
+	aout(L"            __taskrun();\n");
+	aout(L"        else\n");
+	aout(L"            pthread_cond_wait(&__sched.wake, &__sched.lock);\n");
+	aout(L"    }\n");
+	aout(L"    pthread_mutex_unlock(&__sched.lock);\n");
+	aout(L"}\n\n");
+}
+
+/*
+ * A procedure's entry from the scheduler: arguments first, then its
+ * lifted variables.
+ */
+static void
+cg_thunk(HashNode *id, long num, long nparams)
+{
+	long i;
+
+	IR_HOOK_ID(CG_THUNK, num, nparams, id);
+
+	aout(L"void\n__task_");
+	cg_name(id, num);
+	aout(L"(long *__a)\n{\n    ");
+	cg_name(id, num);
+	aout(L"(");
+	for (i = 1; i <= nparams; i++)
+		aout(i > 1 ? L", __a[%ld]" : L"__a[%ld]", i);
+}
+
+static void
+cg_endthunk(long first, long nlifted)
+{
+	long i;
+
+	IR_HOOK(CG_ENDTHUNK, first, nlifted);
+
+	for (i = first; i < first + nlifted; i++)
+		aout(i > 1 ? L", (long *) __a[%ld]" : L"(long *) __a[%ld]", i);
+	aout(L");\n}\n\n");
+}
+
+static void
+cg_odd(void)
+{
+	IR_HOOK(CG_ODD, 0, 0);
+
+	aout(L")&1");
+}
+
+static void
+cg_writechar(int isIdent, long value)
+{
+	IR_HOOK(CG_WRITECHAR, isIdent, value);
+
+	if (freestanding) {
+		if (isIdent)
+			aout(L"__putwc(%s);", tokid->value);
+		else
+			aout(L"__putwc(%ld);", value);
+		return;
+	}
+	/* Bytes, as अंक_लिखें writes: a stream takes one orientation only. */
+	if(isIdent)
+		aout(L"(void) fprintf(stdout, \"%%lc\", (wint_t) %s);",
+		    tokid->value);
+	else
+		aout(L"(void) fprintf(stdout, \"%%lc\", (wint_t) %ld);", value);
+
+}
+
+static void
+cg_readint(void)
+{
+	IR_HOOK(CG_READINT, 0, 0);
+
+	if (freestanding) {
+		aout(L"%s = __readint();\n", tokid->value);
+		return;
+	}
+    /* Portable integer input using strtoll */
+    aout(L"char __stdin[64];\n");
+    aout(L"char *endptr;\n");
+    aout(L"long long __val_ll;\n");
+    aout(L"if (!fgets(__stdin, sizeof(__stdin), stdin)) { perror(\"fgets\"); exit(1); }\n");
+    aout(L"if(__stdin[strlen(__stdin) - 1] == '\\n') __stdin[strlen(__stdin) - 1] = '\\0';\n");
+    aout(L"errno = 0;\n");
+    aout(L"__val_ll = strtoll(__stdin, &endptr, 10);\n");
+    aout(L"if (endptr == __stdin || *endptr != '\\0' || (errno == ERANGE && (__val_ll == LLONG_MAX || __val_ll == LLONG_MIN))) {\n");
+    aout(L"    (void) fprintf(stderr, \"invalid number: %%s\\n\", __stdin);\n");
+    aout(L"    exit(1);\n");
+    aout(L"}\n");
+    aout(L"%s = (long) __val_ll;\n", tokid->value);
+}
+
+static void
+cg_writeint(int isIdent, long value)
+{
+	IR_HOOK(CG_WRITEINT, isIdent, value);
+
+	if (freestanding) {
+		if (isIdent)
+			aout(L"__putint(%s);", tokid->value);
+		else
+			aout(L"__putint(%ld);", value);
+		return;
+	}
+	if(isIdent)
+		aout(L"(void) fprintf(stdout, \"%%ld\", (long) %s);", tokid->value);
+	else
+		aout(L"(void) fprintf(stdout, \"%%ld\", (long) %ld);", value);
+}
+
+/*
+ * The profiler counts calls, loop iterations and the tests of conditions
+ * exactly, in counters of each thread's own that cost no more than a
+ * plain increment; a thread
+ * adds its counters to a list at its start, and the list is summed at
+ * exit.  Calls also keep a stack of frames, which a timer samples as the
+ * program uses CPU time: the function on top has the sample to itself,
+ * and every function below shares it.  Reading a clock around each call
+ * instead costs many times a small procedure's body.  The top of the
+ * stack is volatile, so that the C compiler keeps pushes the timer
+ * alone can see.
+ */
+static void
+cg_profinit(void)
+{
+
+	aout(L"#include <signal.h>\n");
+	aout(L"#include <string.h>\n");
+	aout(L"#include <sys/resource.h>\n");
+	aout(L"#include <sys/time.h>\n\n");
+	aout(L"#define __PHZ 1000\n\n");
+	aout(L"struct __pproc {\n");
+	aout(L"    unsigned long calls, total, self, stamp;\n");
+	aout(L"};\n\n");
+	aout(L"struct __ptest {\n");
+	aout(L"    unsigned long n, t;\n");
+	aout(L"};\n\n");
+	aout(L"struct __pframe {\n");
+	aout(L"    struct __pframe *up;\n");
+	aout(L"    struct __pproc *p;\n");
+	aout(L"};\n\n");
+	aout(L"struct __pthread {\n");
+	aout(L"    struct __pthread *next;\n");
+	aout(L"    struct __pproc *procs;\n");
+	aout(L"    unsigned long *loops;\n");
+	aout(L"    unsigned long *calls;\n");
+	aout(L"    struct __ptest *conds;\n");
+	aout(L"    unsigned long *ticks;\n");
+	aout(L"};\n\n");
+	aout(L"extern __thread struct __pproc __pprocs[];\n");
+	aout(L"extern __thread unsigned long __ploops[];\n");
+	aout(L"extern __thread unsigned long __pcalls[];\n");
+	aout(L"extern __thread struct __ptest __pconds[];\n");
+	aout(L"static __thread struct __pframe *volatile __ptop;\n");
+	aout(L"static __thread struct __pthread __pself;\n");
+	aout(L"static __thread unsigned long __pticks;\n");
+	aout(L"static struct __pthread *__pthreads;\n");
+	aout(L"static void __preport(void);\n\n");
+	aout(L"static void\n");
+	aout(L"__pjoin(void)\n");
+	aout(L"{\n");
+	aout(L"    __pself.procs = __pprocs;\n");
+	aout(L"    __pself.loops = __ploops;\n");
+	aout(L"    __pself.calls = __pcalls;\n");
+	aout(L"    __pself.conds = __pconds;\n");
+	aout(L"    __pself.ticks = &__pticks;\n");
+	aout(L"    __pself.next = __atomic_load_n(&__pthreads, __ATOMIC_RELAXED);\n");
+	aout(L"    while (!__atomic_compare_exchange_n(&__pthreads, &__pself.next, &__pself, 0,\n");
+	aout(L"        __ATOMIC_RELEASE, __ATOMIC_RELAXED))\n");
+	aout(L"        ;\n");
+	aout(L"}\n\n");
+	aout(L"static void\n");
+	aout(L"__ptick(int sig)\n");
+	aout(L"{\n");
+	aout(L"    struct __pframe *f = __ptop;\n");
+	aout(L"    unsigned long now = ++__pticks;\n\n");
+	aout(L"    (void) sig;\n");
+	aout(L"    if (f == NULL)\n");
+	aout(L"        return;\n");
+	aout(L"    f->p->self++;\n");
+	aout(L"    for (; f != NULL; f = f->up) {\n");
+	aout(L"        if (f->p->stamp != now) {\n");
+	aout(L"            f->p->stamp = now;\n");
+	aout(L"            f->p->total++;\n");
+	aout(L"        }\n");
+	aout(L"    }\n");
+	aout(L"}\n\n");
+	aout(L"static void\n");
+	aout(L"__pstart(void)\n");
+	aout(L"{\n");
+	aout(L"    struct itimerval it = { { 0, 1000000 / __PHZ }, { 0, 1000000 / __PHZ } };\n");
+	aout(L"    struct sigaction sa;\n\n");
+	aout(L"    memset(&sa, 0, sizeof(sa));\n");
+	aout(L"    sa.sa_handler = __ptick;\n");
+	aout(L"    sa.sa_flags = SA_RESTART;\n");
+	aout(L"    sigemptyset(&sa.sa_mask);\n");
+	aout(L"    (void) sigaction(SIGPROF, &sa, NULL);\n");
+	aout(L"    (void) setitimer(ITIMER_PROF, &it, NULL);\n");
+	aout(L"    atexit(__preport);\n");
+	aout(L"    __pjoin();\n");
+	aout(L"}\n\n");
+	aout(L"static inline long\n");
+	aout(L"__pcond(struct __ptest *c, long v)\n");
+	aout(L"{\n");
+	aout(L"    c->n++;\n");
+	aout(L"    c->t += v != 0;\n");
+	aout(L"    return v;\n");
+	aout(L"}\n\n");
+	aout(L"static inline void\n");
+	aout(L"__pexit(struct __pframe *f)\n");
+	aout(L"{\n");
+	aout(L"    __ptop = f->up;\n");
+	aout(L"}\n\n");
+	aout(L"/* The frame is whole before the timer can see it. */\n");
+	aout(L"#define __PENTER(k)                                  \\\n");
+	aout(L"    struct __pframe __pf __attribute__((cleanup(__pexit))) = \\\n");
+	aout(L"        { __ptop, &__pprocs[k] };                   \\\n");
+	aout(L"    __pf.p->calls++;                                \\\n");
+	aout(L"    __asm__ __volatile__(\"\" ::: \"memory\");          \\\n");
+	aout(L"    __ptop = &__pf\n\n");
+}
+
+/*
+ * The counters, the sites they count and the report written at exit,
+ * once every site is known.  HINDIPL0_PROFILE names the report file.
+ */
+static void
+cg_report(void)
+{
+	size_t i;
+
+	aout(L"__thread struct __pproc __pprocs[%zu];\n", ncgprocs);
+	aout(L"__thread unsigned long __ploops[%zu];\n",
+	    ncgloops ? ncgloops : 1);
+	aout(L"__thread unsigned long __pcalls[%zu];\n",
+	    ncgcalls ? ncgcalls : 1);
+	aout(L"__thread struct __ptest __pconds[%zu];\n\n",
+	    ncgconds ? ncgconds : 1);
+	aout(L"static const struct {\n");
+	aout(L"    const char *name;\n");
+	aout(L"    long line, at;\n");
+	aout(L"} __pprocsite[] = {\n");
+	for (i = 0; i < ncgprocs; i++)
+		aout(L"    { \"%ls\", %ld, 0 },\n", cgprocs[i].name,
+		    cgprocs[i].line);
+	aout(L"}, __ploopsite[] = {\n");
+	for (i = 0; i < ncgloops; i++)
+		aout(L"    { \"%ls\", %ld, %ld },\n",
+		    cgprocs[cgloops[i].proc].name, cgloops[i].line,
+		    cgloops[i].at);
+	if (ncgloops == 0)
+		aout(L"    { NULL, 0, 0 },\n");
+	aout(L"}, __pcondsite[] = {\n");
+	for (i = 0; i < ncgconds; i++)
+		aout(L"    { \"%ls\", %ld, %ld },\n",
+		    cgprocs[cgconds[i].proc].name, cgconds[i].line,
+		    cgconds[i].at);
+	if (ncgconds == 0)
+		aout(L"    { NULL, 0, 0 },\n");
+	aout(L"};\n\n");
+	aout(L"static const struct {\n");
+	aout(L"    const char *name, *callee, *kind;\n");
+	aout(L"    long line, at;\n");
+	aout(L"} __pcallsite[] = {\n");
+	for (i = 0; i < ncgcalls; i++)
+		aout(L"    { \"%ls\", \"%ls\", \"%s\", %ld, %ld },\n",
+		    cgprocs[cgcalls[i].proc].name, cgcalls[i].name,
+		    cgcalls[i].task ? "task" : "call", cgcalls[i].line,
+		    cgcalls[i].at);
+	if (ncgcalls == 0)
+		aout(L"    { NULL, NULL, NULL, 0, 0 },\n");
+	aout(L"};\n\n");
+	aout(L"struct __prow {\n");
+	aout(L"    unsigned long key, i, count, total, self;\n");
+	aout(L"};\n\n");
+	aout(L"static int\n");
+	aout(L"__pcmp(const void *a, const void *b)\n");
+	aout(L"{\n");
+	aout(L"    const struct __prow *x = a, *y = b;\n\n");
+	aout(L"    if (x->key != y->key)\n");
+	aout(L"        return x->key < y->key ? 1 : -1;\n");
+	aout(L"    return x->i < y->i ? -1 : x->i > y->i;\n");
+	aout(L"}\n\n");
+	aout(L"/* A condition's total is how many of its tests held. */\n");
+	aout(L"static void\n");
+	aout(L"__preport(void)\n");
+	aout(L"{\n");
+	aout(L"    struct __prow p[%zu], l[%zu], c[%zu], d[%zu];\n", ncgprocs,
+	    ncgloops ? ncgloops : 1, ncgcalls ? ncgcalls : 1,
+	    ncgconds ? ncgconds : 1);
+	aout(L"    struct itimerval off = { { 0, 0 }, { 0, 0 } };\n");
+	aout(L"    struct __pthread *t;\n");
+	aout(L"    struct rusage ru;\n");
+	aout(L"    unsigned long i, n = 0, ticks = 0;\n");
+	aout(L"    double share;\n");
+	aout(L"    char *path;\n");
+	aout(L"    FILE *f;\n\n");
+	aout(L"    (void) setitimer(ITIMER_PROF, &off, NULL);\n");
+	aout(L"    (void) getrusage(RUSAGE_SELF, &ru);\n");
+	aout(L"    memset(p, 0, sizeof(p));\n");
+	aout(L"    memset(l, 0, sizeof(l));\n");
+	aout(L"    memset(c, 0, sizeof(c));\n");
+	aout(L"    memset(d, 0, sizeof(d));\n");
+	aout(L"    for (t = __atomic_load_n(&__pthreads, __ATOMIC_ACQUIRE); t != NULL; t = t->next, n++) {\n");
+	aout(L"        ticks += *t->ticks;\n");
+	aout(L"        for (i = 0; i < %zu; i++) {\n", ncgprocs);
+	aout(L"            p[i].count += t->procs[i].calls;\n");
+	aout(L"            p[i].total += t->procs[i].total;\n");
+	aout(L"            p[i].self += t->procs[i].self;\n");
+	aout(L"        }\n");
+	aout(L"        for (i = 0; i < %zu; i++)\n", ncgloops);
+	aout(L"            l[i].count += t->loops[i];\n");
+	aout(L"        for (i = 0; i < %zu; i++)\n", ncgcalls);
+	aout(L"            c[i].count += t->calls[i];\n");
+	aout(L"        for (i = 0; i < %zu; i++) {\n", ncgconds);
+	aout(L"            d[i].count += t->conds[i].n;\n");
+	aout(L"            d[i].total += t->conds[i].t;\n");
+	aout(L"        }\n");
+	aout(L"    }\n");
+	aout(L"    for (i = 0; i < %zu; i++) {\n", ncgprocs);
+	aout(L"        p[i].i = i;\n");
+	aout(L"        p[i].key = p[i].self;\n");
+	aout(L"    }\n");
+	aout(L"    for (i = 0; i < %zu; i++) {\n", ncgloops);
+	aout(L"        l[i].i = i;\n");
+	aout(L"        l[i].key = l[i].count;\n");
+	aout(L"    }\n");
+	aout(L"    for (i = 0; i < %zu; i++) {\n", ncgcalls);
+	aout(L"        c[i].i = i;\n");
+	aout(L"        c[i].key = c[i].count;\n");
+	aout(L"    }\n");
+	aout(L"    for (i = 0; i < %zu; i++) {\n", ncgconds);
+	aout(L"        d[i].i = i;\n");
+	aout(L"        d[i].key = d[i].count;\n");
+	aout(L"    }\n");
+	aout(L"    qsort(p, %zu, sizeof(*p), __pcmp);\n", ncgprocs);
+	aout(L"    qsort(l, %zu, sizeof(*l), __pcmp);\n", ncgloops);
+	aout(L"    qsort(c, %zu, sizeof(*c), __pcmp);\n", ncgcalls);
+	aout(L"    qsort(d, %zu, sizeof(*d), __pcmp);\n\n", ncgconds);
+	aout(L"    if ((path = getenv(\"HINDIPL0_PROFILE\")) == NULL)\n");
+	aout(L"        path = \"hindipl0.prof\";\n");
+	aout(L"    if ((f = fopen(path, \"w\")) == NULL) {\n");
+	aout(L"        perror(path);\n");
+	aout(L"        return;\n");
+	aout(L"    }\n");
+	aout(L"    (void) fprintf(f, \"# hindipl0c profile: %%lu thread%%s, %%ld ms of CPU, %%lu samples\\n\",\n");
+	aout(L"        n, n == 1 ? \"\" : \"s\", (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000L +\n");
+	aout(L"        (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000, ticks);\n");
+	aout(L"    (void) fprintf(f, \"# kind   line  at          count  total %%%%   self %%%%  name\\n\");\n");
+	aout(L"    share = ticks ? 100.0 / ticks : 0;\n");
+	aout(L"    for (i = 0; i < %zu; i++)\n", ncgprocs);
+	aout(L"        (void) fprintf(f, \"proc %%6ld   - %%14lu %%8.1f %%8.1f  %%s\\n\", __pprocsite[p[i].i].line,\n");
+	aout(L"            p[i].count, p[i].total * share, p[i].self * share, __pprocsite[p[i].i].name);\n");
+	aout(L"    for (i = 0; i < %zu; i++)\n", ncgloops);
+	aout(L"        (void) fprintf(f, \"loop %%6ld %%3ld %%14lu %%8s %%8s  %%s\\n\", __ploopsite[l[i].i].line,\n");
+	aout(L"            __ploopsite[l[i].i].at, l[i].count, \"-\", \"-\", __ploopsite[l[i].i].name);\n");
+	aout(L"    for (i = 0; i < %zu; i++)\n", ncgcalls);
+	aout(L"        (void) fprintf(f, \"%%s %%6ld %%3ld %%14lu %%8s %%8s  %%s %%s\\n\", __pcallsite[c[i].i].kind,\n");
+	aout(L"            __pcallsite[c[i].i].line, __pcallsite[c[i].i].at, c[i].count, \"-\", \"-\", __pcallsite[c[i].i].name, __pcallsite[c[i].i].callee);\n");
+	aout(L"    for (i = 0; i < %zu; i++)\n", ncgconds);
+	aout(L"        (void) fprintf(f, \"cond %%6ld %%3ld %%14lu %%8.1f %%8s  %%s\\n\", __pcondsite[d[i].i].line,\n");
+	aout(L"            __pcondsite[d[i].i].at, d[i].count, d[i].count ? d[i].total * 100.0 / d[i].count : 0, \"-\",\n");
+	aout(L"            __pcondsite[d[i].i].name);\n");
+	aout(L"    (void) fclose(f);\n");
+	aout(L"}\n");
+}
+
+/*
+ * Calls to the pure procedure id go through id__memo, defined after the
+ * program once whether tasks may call it from other threads is known.
+ * The globals in its key follow.
+ */
+static void
+cg_memo(HashNode *id, long nparams)
+{
+	struct cgmemo *m;
+	long i;
+
+	IR_HOOK_ID(CG_MEMO, nparams, 0, id);
+
+	if (ncgmemos == cgmemocap) {
+		cgmemocap = cgmemocap ? cgmemocap * 2 : 8;
+		cgmemos = realloc(cgmemos, cgmemocap * sizeof(*cgmemos));
+		if (cgmemos == NULL)
+			error("malloc failed");
+	}
+	m = &cgmemos[ncgmemos++];
+	m->id = id;
+	m->nparams = nparams;
+	m->nvars = 0;
+	aout(L"static long %hs__memo(", id->value);
+	for (i = 0; i < nparams; i++)
+		aout(i ? L", long" : L"long");
+	aout(L"%ls);\n", nparams ? L"" : L"void");
+}
+
+/*
+ * A global read by the last memoized procedure, and written if out.
+ */
+static void
+cg_memovar(HashNode *id, long out)
+{
+	struct cgmemo *m = &cgmemos[ncgmemos - 1];
+
+	IR_HOOK_ID(CG_MEMOVAR, out, 0, id);
+
+	m->vars[m->nvars] = id;
+	m->out[m->nvars++] = out;
+}
+
+/*
+ * Each cache has 1 << MEMO_BITS entries, picked by a hash of the key: a
+ * call whose key matches the entry's returns its value and sets the
+ * globals to what the call that filled it left them.  A miss calls the
+ * procedure and fills the entry.  With tasks, each thread has its own
+ * caches.  The calls and hits are written to stderr at exit.
+ */
+static void
+cg_memos(void)
+{
+	struct cgmemo *m;
+	size_t i;
+	long j, k, nkeys, nouts;
+
+	for (i = 0; i < ncgmemos; i++) {
+		m = &cgmemos[i];
+		nkeys = m->nparams + m->nvars;
+		for (j = nouts = 0; j < m->nvars; j++)
+			nouts += m->out[j];
+		aout(L"\n/* %ls, memoized (--memo). */\n", m->id->key);
+		aout(L"static %lsstruct {\n", cgtasking ? L"__thread " : L"");
+		aout(L"    long k[%ld], o[%ld];\n", nkeys + 1, nouts + 1);
+		aout(L"    int full;\n");
+		aout(L"} __mtab%zu[%d];\n", i, 1 << MEMO_BITS);
+		aout(L"static unsigned long __mcalls%zu, __mhits%zu;\n\n", i, i);
+		aout(L"static long\n");
+		aout(L"%hs__memo(", m->id->value);
+		for (j = 0; j < m->nparams; j++)
+			aout(L"%lslong __a%ld", j > 0 ? L", " : L"", j);
+		aout(L"%ls)\n", m->nparams ? L"" : L"void");
+		aout(L"{\n");
+		aout(L"    const long k[] = { ");
+		for (j = 0; j < m->nparams; j++)
+			aout(L"__a%ld, ", j);
+		for (j = 0; j < m->nvars; j++)
+			aout(L"%hs, ", m->vars[j]->value);
+		aout(L"0 };\n");
+		aout(L"    unsigned long h = 0;\n");
+		aout(L"    long r;\n");
+		aout(L"    int i;\n\n");
+		aout(L"    for (i = 0; i < %ld; i++)\n", nkeys);
+		aout(L"        h = (h ^ (unsigned long) k[i]) * 0x9e3779b97f4a7c15UL;\n");
+		aout(L"    h >>= %d;\n", 64 - MEMO_BITS);
+		if (cgtasking) {
+			aout(L"    __atomic_fetch_add(&__mcalls%zu, 1, __ATOMIC_RELAXED);\n", i);
+		} else
+			aout(L"    __mcalls%zu++;\n", i);
+		aout(L"    for (i = 0; i < %ld && k[i] == __mtab%zu[h].k[i]; i++)\n",
+		    nkeys, i);
+		aout(L"        ;\n");
+		aout(L"    if (i == %ld && __mtab%zu[h].full) {\n", nkeys, i);
+		if (cgtasking) {
+			aout(L"        __atomic_fetch_add(&__mhits%zu, 1, __ATOMIC_RELAXED);\n", i);
+		} else
+			aout(L"        __mhits%zu++;\n", i);
+		for (j = k = 0; j < m->nvars; j++) {
+			if (m->out[j])
+				aout(L"        %hs = __mtab%zu[h].o[%ld];\n",
+				    m->vars[j]->value, i, ++k);
+		}
+		aout(L"        return __mtab%zu[h].o[0];\n", i);
+		aout(L"    }\n");
+		aout(L"    r = %hs(", m->id->value);
+		for (j = 0; j < m->nparams; j++)
+			aout(L"%ls__a%ld", j > 0 ? L", " : L"", j);
+		aout(L");\n");
+		aout(L"    for (i = 0; i < %ld; i++)\n", nkeys);
+		aout(L"        __mtab%zu[h].k[i] = k[i];\n", i);
+		aout(L"    __mtab%zu[h].o[0] = r;\n", i);
+		for (j = k = 0; j < m->nvars; j++) {
+			if (m->out[j])
+				aout(L"    __mtab%zu[h].o[%ld] = %hs;\n", i, ++k,
+				    m->vars[j]->value);
+		}
+		aout(L"    __mtab%zu[h].full = 1;\n", i);
+		aout(L"    return r;\n");
+		aout(L"}\n");
+	}
+
+	aout(L"\nstatic void\n");
+	aout(L"__mreport(void)\n");
+	aout(L"{\n");
+	aout(L"    (void) fprintf(stderr, \"# hindipl0c memo: calls, hits and hit rate per procedure\\n\");\n");
+	for (i = 0; i < ncgmemos; i++) {
+		aout(L"    (void) fprintf(stderr, \"memo %%14lu %%14lu %%8.1f  %%s\\n\", __mcalls%zu, __mhits%zu,\n",
+		    i, i);
+		aout(L"        __mcalls%zu ? __mhits%zu * 100.0 / __mcalls%zu : 0, \"%ls\");\n",
+		    i, i, i, cgmemos[i].id->key);
+	}
+	aout(L"}\n");
+}
+
+/*
+ * The runtime of a freestanding program (--freestanding), in place of the
+ * C library: an entry point, system calls, buffered output, and its own
+ * UTF-8 and number conversions, with no locale.  Output goes through one
+ * buffer, flushed before reading and at exit, so numbers and characters
+ * keep their order.
+ */
+static void
+cg_freeinit(void)
+{
+
+	aout(L"/* The freestanding runtime: Linux system calls, and no C library. */\n");
+	aout(L"#include <limits.h>\n");
+	aout(L"#include <stddef.h>\n\n");
+	aout(L"#if defined(__x86_64__)\n");
+	aout(L"#define __SYS_READ 0\n");
+	aout(L"#define __SYS_WRITE 1\n");
+	aout(L"#define __SYS_EXIT_GROUP 231\n\n");
+	aout(L"/* The thread's control block, and the stack protector's canary in it. */\n");
+	aout(L"unsigned long __tcb[8];\n\n");
+	aout(L"static inline long\n");
+	aout(L"__syscall3(long n, long a, long b, long c)\n");
+	aout(L"{\n");
+	aout(L"    long r;\n\n");
+	aout(L"    __asm__ __volatile__(\"syscall\" : \"=a\"(r) : \"a\"(n), \"D\"(a), \"S\"(b), \"d\"(c) : \"rcx\", \"r11\", \"memory\");\n");
+	aout(L"    return r;\n");
+	aout(L"}\n\n");
+	aout(L"/* %%fs points at __tcb before any code the stack protector reads it in. */\n");
+	aout(L"__asm__(\".text\\n\"\n");
+	aout(L"    \".globl _start\\n\"\n");
+	aout(L"    \"_start:\\n\"\n");
+	aout(L"    \"    xor %%ebp, %%ebp\\n\"\n");
+	aout(L"    \"    mov %%rsp, %%rbx\\n\"\n");
+	aout(L"    \"    lea __tcb(%%rip), %%rsi\\n\"\n");
+	aout(L"    \"    mov %%rsi, (%%rsi)\\n\"\n");
+	aout(L"    \"    mov $0x1002, %%edi\\n\"\n");
+	aout(L"    \"    mov $158, %%eax\\n\"\n");
+	aout(L"    \"    syscall\\n\"\n");
+	aout(L"    \"    mov %%rbx, %%rdi\\n\"\n");
+	aout(L"    \"    and $-16, %%rsp\\n\"\n");
+	aout(L"    \"    call __start\\n\"\n");
+	aout(L"    \"    hlt\\n\");\n\n");
+	aout(L"#define __CANARY (__tcb[5])\n\n");
+	aout(L"void *\n");
+	aout(L"memcpy(void *d, const void *s, size_t n)\n");
+	aout(L"{\n");
+	aout(L"    void *r = d;\n\n");
+	aout(L"    __asm__ __volatile__(\"rep movsb\" : \"+D\"(d), \"+S\"(s), \"+c\"(n) : : \"memory\");\n");
+	aout(L"    return r;\n");
+	aout(L"}\n\n");
+	aout(L"void *\n");
+	aout(L"memset(void *d, int c, size_t n)\n");
+	aout(L"{\n");
+	aout(L"    void *r = d;\n\n");
+	aout(L"    __asm__ __volatile__(\"rep stosb\" : \"+D\"(d), \"+c\"(n) : \"a\"(c) : \"memory\");\n");
+	aout(L"    return r;\n");
+	aout(L"}\n");
+	aout(L"#elif defined(__aarch64__)\n");
+	aout(L"#define __SYS_READ 63\n");
+	aout(L"#define __SYS_WRITE 64\n");
+	aout(L"#define __SYS_EXIT_GROUP 94\n\n");
+	aout(L"static inline long\n");
+	aout(L"__syscall3(long n, long a, long b, long c)\n");
+	aout(L"{\n");
+	aout(L"    register long x8 __asm__(\"x8\") = n, x0 __asm__(\"x0\") = a;\n");
+	aout(L"    register long x1 __asm__(\"x1\") = b, x2 __asm__(\"x2\") = c;\n\n");
+	aout(L"    __asm__ __volatile__(\"svc 0\" : \"+r\"(x0) : \"r\"(x8), \"r\"(x1), \"r\"(x2) : \"memory\");\n");
+	aout(L"    return x0;\n");
+	aout(L"}\n\n");
+	aout(L"__asm__(\".text\\n\"\n");
+	aout(L"    \".globl _start\\n\"\n");
+	aout(L"    \"_start:\\n\"\n");
+	aout(L"    \"    mov x29, #0\\n\"\n");
+	aout(L"    \"    mov x30, #0\\n\"\n");
+	aout(L"    \"    mov x0, sp\\n\"\n");
+	aout(L"    \"    bl __start\\n\");\n\n");
+	aout(L"unsigned long __stack_chk_guard;\n");
+	aout(L"#define __CANARY __stack_chk_guard\n\n");
+	aout(L"/* The empty asm keeps the C compiler from making these loops calls. */\n");
+	aout(L"void *\n");
+	aout(L"memcpy(void *d, const void *s, size_t n)\n");
+	aout(L"{\n");
+	aout(L"    unsigned char *p = d;\n");
+	aout(L"    const unsigned char *q = s;\n\n");
+	aout(L"    while (n-- > 0) {\n");
+	aout(L"        *p++ = *q++;\n");
+	aout(L"        __asm__(\"\" : \"+r\"(p));\n");
+	aout(L"    }\n");
+	aout(L"    return d;\n");
+	aout(L"}\n\n");
+	aout(L"void *\n");
+	aout(L"memset(void *d, int c, size_t n)\n");
+	aout(L"{\n");
+	aout(L"    unsigned char *p = d;\n\n");
+	aout(L"    while (n-- > 0) {\n");
+	aout(L"        *p++ = (unsigned char) c;\n");
+	aout(L"        __asm__(\"\" : \"+r\"(p));\n");
+	aout(L"    }\n");
+	aout(L"    return d;\n");
+	aout(L"}\n");
+	aout(L"#else\n");
+	aout(L"#error \"--freestanding needs Linux on x86-64 or AArch64\"\n");
+	aout(L"#endif\n\n");
+	aout(L"static char __obuf[8192], __ibuf[8192], __ebuf[256];\n");
+	aout(L"static size_t __olen, __ipos, __ilen, __elen;\n\n");
+	aout(L"static void\n");
+	aout(L"__write(int fd, const char *s, size_t n)\n");
+	aout(L"{\n");
+	aout(L"    long r;\n\n");
+	aout(L"    while (n > 0) {\n");
+	aout(L"        if ((r = __syscall3(__SYS_WRITE, fd, (long) s, (long) n)) < 0) {\n");
+	aout(L"            if (r == -4)\n");
+	aout(L"                continue;\n");
+	aout(L"            return;\n");
+	aout(L"        }\n");
+	aout(L"        s += r;\n");
+	aout(L"        n -= r;\n");
+	aout(L"    }\n");
+	aout(L"}\n\n");
+	aout(L"static void\n");
+	aout(L"__flush(void)\n");
+	aout(L"{\n");
+	aout(L"    __write(1, __obuf, __olen);\n");
+	aout(L"    __olen = 0;\n");
+	aout(L"}\n\n");
+	aout(L"static void __attribute__((noreturn))\n");
+	aout(L"__exit(long status)\n");
+	aout(L"{\n");
+	aout(L"    __flush();\n");
+	aout(L"    for (;;)\n");
+	aout(L"        (void) __syscall3(__SYS_EXIT_GROUP, status, 0, 0);\n");
+	aout(L"}\n\n");
+	aout(L"/* The digits of v, ending at end. */\n");
+	aout(L"static char *\n");
+	aout(L"__digits(char *end, long v)\n");
+	aout(L"{\n");
+	aout(L"    unsigned long u = v < 0 ? -(unsigned long) v : (unsigned long) v;\n\n");
+	aout(L"    do\n");
+	aout(L"        *--end = '0' + u %% 10;\n");
+	aout(L"    while ((u /= 10) != 0);\n");
+	aout(L"    if (v < 0)\n");
+	aout(L"        *--end = '-';\n");
+	aout(L"    return end;\n");
+	aout(L"}\n\n");
+	aout(L"static void\n");
+	aout(L"__put(const char *s, size_t n)\n");
+	aout(L"{\n");
+	aout(L"    if (__olen + n > sizeof(__obuf))\n");
+	aout(L"        __flush();\n");
+	aout(L"    memcpy(__obuf + __olen, s, n);\n");
+	aout(L"    __olen += n;\n");
+	aout(L"}\n\n");
+	aout(L"static void\n");
+	aout(L"__putint(long v)\n");
+	aout(L"{\n");
+	aout(L"    char b[20], *s = __digits(b + sizeof(b), v);\n\n");
+	aout(L"    __put(s, b + sizeof(b) - s);\n");
+	aout(L"}\n\n");
+	aout(L"/* As wprintf's %%lc: UTF-8, and nothing for what is not a character. */\n");
+	aout(L"static void\n");
+	aout(L"__putwc(long v)\n");
+	aout(L"{\n");
+	aout(L"    unsigned int c = (unsigned int) v;\n");
+	aout(L"    char b[4];\n\n");
+	aout(L"    if (c < 0x80) {\n");
+	aout(L"        b[0] = c;\n");
+	aout(L"        __put(b, 1);\n");
+	aout(L"    } else if (c < 0x800) {\n");
+	aout(L"        b[0] = 0xc0 | c >> 6;\n");
+	aout(L"        b[1] = 0x80 | (c & 0x3f);\n");
+	aout(L"        __put(b, 2);\n");
+	aout(L"    } else if (c < 0x10000) {\n");
+	aout(L"        if (c >= 0xd800 && c <= 0xdfff)\n");
+	aout(L"            return;\n");
+	aout(L"        b[0] = 0xe0 | c >> 12;\n");
+	aout(L"        b[1] = 0x80 | (c >> 6 & 0x3f);\n");
+	aout(L"        b[2] = 0x80 | (c & 0x3f);\n");
+	aout(L"        __put(b, 3);\n");
+	aout(L"    } else if (c <= 0x10ffff) {\n");
+	aout(L"        b[0] = 0xf0 | c >> 18;\n");
+	aout(L"        b[1] = 0x80 | (c >> 12 & 0x3f);\n");
+	aout(L"        b[2] = 0x80 | (c >> 6 & 0x3f);\n");
+	aout(L"        b[3] = 0x80 | (c & 0x3f);\n");
+	aout(L"        __put(b, 4);\n");
+	aout(L"    }\n");
+	aout(L"}\n\n");
+	aout(L"/* A message for stderr, written whole by __die. */\n");
+	aout(L"static void\n");
+	aout(L"__eputs(const char *s)\n");
+	aout(L"{\n");
+	aout(L"    while (*s != '\\0' && __elen < sizeof(__ebuf))\n");
+	aout(L"        __ebuf[__elen++] = *s++;\n");
+	aout(L"}\n\n");
+	aout(L"static void\n");
+	aout(L"__eputl(long v)\n");
+	aout(L"{\n");
+	aout(L"    char b[21], *s = __digits(b + sizeof(b) - 1, v);\n\n");
+	aout(L"    b[sizeof(b) - 1] = '\\0';\n");
+	aout(L"    __eputs(s);\n");
+	aout(L"}\n\n");
+	aout(L"static void __attribute__((noreturn, cold))\n");
+	aout(L"__die(void)\n");
+	aout(L"{\n");
+	aout(L"    __flush();\n");
+	aout(L"    __write(2, __ebuf, __elen);\n");
+	aout(L"    __exit(1);\n");
+	aout(L"}\n\n");
+	aout(L"void __attribute__((noreturn))\n");
+	aout(L"__stack_chk_fail(void)\n");
+	aout(L"{\n");
+	aout(L"    __eputs(\"stack smashing detected\\n\");\n");
+	aout(L"    __die();\n");
+	aout(L"}\n\n");
+	aout(L"/* The next byte of stdin, or -1 at its end. */\n");
+	aout(L"static int\n");
+	aout(L"__getbyte(void)\n");
+	aout(L"{\n");
+	aout(L"    long r;\n\n");
+	aout(L"    if (__ipos == __ilen) {\n");
+	aout(L"        __flush();\n");
+	aout(L"        while ((r = __syscall3(__SYS_READ, 0, (long) __ibuf, sizeof(__ibuf))) == -4)\n");
+	aout(L"            ;\n");
+	aout(L"        if (r <= 0)\n");
+	aout(L"            return -1;\n");
+	aout(L"        __ipos = 0;\n");
+	aout(L"        __ilen = r;\n");
+	aout(L"    }\n");
+	aout(L"    return (unsigned char) __ibuf[__ipos++];\n");
+	aout(L"}\n\n");
+	aout(L"/* As fgetwc in a UTF-8 locale, where an invalid sequence is an error. */\n");
+	aout(L"static long\n");
+	aout(L"__readchar(void)\n");
+	aout(L"{\n");
+	aout(L"    static const long least[] = { 0, 0x80, 0x800, 0x10000 };\n");
+	aout(L"    long c;\n");
+	aout(L"    int b, i, n;\n\n");
+	aout(L"    if ((b = __getbyte()) >= 0 && b < 0x80)\n");
+	aout(L"        return b;\n");
+	aout(L"    n = b >= 0xf0 ? 3 : b >= 0xe0 ? 2 : b >= 0xc0 ? 1 : 0;\n");
+	aout(L"    if (n == 0 || b >= 0xf8)\n");
+	aout(L"        goto bad;\n");
+	aout(L"    c = b & 0x3f >> n;\n");
+	aout(L"    for (i = 0; i < n; i++) {\n");
+	aout(L"        if (((b = __getbyte()) & 0xc0) != 0x80)\n");
+	aout(L"            goto bad;\n");
+	aout(L"        c = c << 6 | (b & 0x3f);\n");
+	aout(L"    }\n");
+	aout(L"    if (c >= least[n] && c <= 0x10ffff && (c < 0xd800 || c > 0xdfff))\n");
+	aout(L"        return c;\n");
+	aout(L"bad:\n");
+	aout(L"    __eputs(\"unexpected EOF when reading character\\n\");\n");
+	aout(L"    __die();\n");
+	aout(L"}\n\n");
+	aout(L"/* As fgets and strtoll: a line of at most 63 bytes, all one number. */\n");
+	aout(L"static long\n");
+	aout(L"__readint(void)\n");
+	aout(L"{\n");
+	aout(L"    char b[64];\n");
+	aout(L"    unsigned long u = 0, most;\n");
+	aout(L"    size_t i = 0, j = 0, first;\n");
+	aout(L"    int c, neg = 0;\n\n");
+	aout(L"    while (i < sizeof(b) - 1 && (c = __getbyte()) != -1) {\n");
+	aout(L"        b[i++] = c;\n");
+	aout(L"        if (c == '\\n')\n");
+	aout(L"            break;\n");
+	aout(L"    }\n");
+	aout(L"    if (i == 0) {\n");
+	aout(L"        __eputs(\"unexpected EOF when reading number\\n\");\n");
+	aout(L"        __die();\n");
+	aout(L"    }\n");
+	aout(L"    if (b[i - 1] == '\\n')\n");
+	aout(L"        i--;\n");
+	aout(L"    b[i] = '\\0';\n");
+	aout(L"    while (j < i && (b[j] == ' ' || (b[j] >= '\\t' && b[j] <= '\\r')))\n");
+	aout(L"        j++;\n");
+	aout(L"    if (j < i && (b[j] == '+' || b[j] == '-'))\n");
+	aout(L"        neg = b[j++] == '-';\n");
+	aout(L"    most = neg ? (unsigned long) LONG_MAX + 1 : LONG_MAX;\n");
+	aout(L"    for (first = j; j < i && b[j] >= '0' && b[j] <= '9'; j++) {\n");
+	aout(L"        if (u > (most - (b[j] - '0')) / 10)\n");
+	aout(L"            break;\n");
+	aout(L"        u = u * 10 + (b[j] - '0');\n");
+	aout(L"    }\n");
+	aout(L"    if (j == first || j != i) {\n");
+	aout(L"        __eputs(\"invalid number: \");\n");
+	aout(L"        __eputs(b);\n");
+	aout(L"        __eputs(\"\\n\");\n");
+	aout(L"        __die();\n");
+	aout(L"    }\n");
+	aout(L"    return neg ? (long) -u : (long) u;\n");
+	aout(L"}\n\n");
+	aout(L"static long\n");
+	aout(L"__bound(long i, long n, long line)\n");
+	aout(L"{\n");
+	aout(L"    if (i < 0 || i >= n) {\n");
+	aout(L"        __eputs(\"line \");\n");
+	aout(L"        __eputl(line);\n");
+	aout(L"        __eputs(\": index \");\n");
+	aout(L"        __eputl(i);\n");
+	aout(L"        __eputs(\" out of bounds [0, \");\n");
+	aout(L"        __eputl(n);\n");
+	aout(L"        __eputs(\")\\n\");\n");
+	aout(L"        __die();\n");
+	aout(L"    }\n");
+	aout(L"    return i;\n");
+	aout(L"}\n\n");
+	aout(L"int main(int, char *[]);\n\n");
+	aout(L"/*\n");
+	aout(L" * The stack holds argc, the arguments and the environment, then the\n");
+	aout(L" * auxiliary vector, whose AT_RANDOM bytes make the canary.\n");
+	aout(L" */\n");
+	aout(L"void __attribute__((used, noreturn))\n");
+	aout(L"__start(long *sp)\n");
+	aout(L"{\n");
+	aout(L"    unsigned long *a = (unsigned long *) sp + sp[0] + 2;\n\n");
+	aout(L"    while (*a++ != 0)\n");
+	aout(L"        ;\n");
+	aout(L"    for (; a[0] != 0; a += 2) {\n");
+	aout(L"        if (a[0] == 25)\n");
+	aout(L"            __CANARY = *(unsigned long *) a[1] & ~0xffUL;\n");
+	aout(L"    }\n");
+	aout(L"    __exit(main((int) sp[0], (char **) (sp + 1)));\n");
+	aout(L"}\n");
+}
+
+static void
+cg_init(long checked)
+{
+	IR_HOOK(CG_INIT, checked, 0);
+
+	if (freestanding) {
+		cg_freeinit();
+	} else {
+		aout(L"#include <stdio.h>\n");
+		aout(L"#include <stdlib.h>\n");
+		aout(L"#include <wchar.h>\n");
+		aout(L"#include <wctype.h>\n");
+		aout(L"#include <locale.h>\n\n");
+		aout(L"static char __stdin[24];\n\n");
+		aout(L"static long\n");
+		aout(L"__bound(long i, long n, long line)\n");
+		aout(L"{\n");
+		aout(L"    if (i < 0 || i >= n) {\n");
+		aout(L"        (void) fprintf(stderr, \"line %%ld: index %%ld out of bounds [0, %%ld)\\n\", line, i, n);\n");
+		aout(L"        exit(1);\n");
+		aout(L"    }\n");
+		aout(L"    return i;\n");
+		aout(L"}\n\n");
+	}
+	if (profiling)
+		cg_profinit();
+
+	if (!checked)
+		return;
+
+	aout(L"#include <limits.h>\n\n");
+	aout(L"static void __attribute__((noreturn, cold))\n");
+	aout(L"__trap(long line, const char *what)\n");
+	aout(L"{\n");
+	if (freestanding) {
+		aout(L"    __eputs(\"line \");\n");
+		aout(L"    __eputl(line);\n");
+		aout(L"    __eputs(\": \");\n");
+		aout(L"    __eputs(what);\n");
+		aout(L"    __eputs(\"\\n\");\n");
+		aout(L"    __die();\n");
+	} else {
+		aout(L"    (void) fprintf(stderr, \"line %%ld: %%s\\n\", line, what);\n");
+		aout(L"    exit(1);\n");
+	}
+	aout(L"}\n\n");
+	aout(L"#define __CHECKED(name, op)                         \\\n");
+	aout(L"static inline long                                  \\\n");
+	aout(L"__##name(long a, long b, long line)                 \\\n");
+	aout(L"{                                                   \\\n");
+	aout(L"    long r;                                         \\\n");
+	aout(L"                                                    \\\n");
+	aout(L"    if (__builtin_##op##_overflow(a, b, &r))        \\\n");
+	aout(L"        __trap(line, \"overflow\");                  \\\n");
+	aout(L"    return r;                                       \\\n");
+	aout(L"}\n");
+	aout(L"__CHECKED(add, add)\n");
+	aout(L"__CHECKED(sub, sub)\n");
+	aout(L"__CHECKED(mul, mul)\n\n");
+	aout(L"static inline long\n");
+	aout(L"__div(long a, long b, long line)\n");
+	aout(L"{\n");
+	aout(L"    if (b == 0)\n");
+	aout(L"        __trap(line, \"division by zero\");\n");
+	aout(L"    if (a == LONG_MIN && b == -1)\n");
+	aout(L"        __trap(line, \"overflow\");\n");
+	aout(L"    return a / b;\n");
+	aout(L"}\n\n");
+}
+
+
+/*
+ * Common subexpressions.
+ *
+ * A parenthesised expression of scalar variables and constants, with an
+ * operator in it, is looked up by its tokens among those whose values
+ * are available.  A variable changes only when assigned or read into,
+ * or by a call, so an assignment or read drops the values using it, and
+ * a call or a join of control flow drops them all, as do the ends of
+ * their block and of their window.  Expressions are not shared inside a
+ * समानांतर body, where each iteration is a call of its own, nor with -C,
+ * whose checks are per operator.
+ */
+
+static long slot(void);
+
+/*
+ * The declaration slot of the innermost block statement, -1 once closed.
+ */
+static long
+csedecl(void)
+{
+
+	return ncsedecls > 0 ? csedecls[ncsedecls - 1] : -1;
+}
+
+static void
+csetoken(int type, struct symtab *sym, long value)
+{
+	struct csetok *t;
+
+	if (csedepth == 0)
+		return;
+	if (ncsekeys == csekeycap) {
+		csekeycap = csekeycap ? csekeycap * 2 : 64;
+		csekeys = realloc(csekeys, csekeycap * sizeof(*csekeys));
+		if (csekeys == NULL)
+			error("malloc failed");
+	}
+	t = &csekeys[ncsekeys++];
+	t->type = type;
+	t->sym = sym;
+	t->value = value;
+	if (type != TOK_IDENT && type != TOK_NUMBER &&
+	    type != TOK_LPAREN && type != TOK_RPAREN)
+		cseops++;
+}
+
+static unsigned long
+csehash(const struct csetok *key, size_t len)
+{
+	unsigned long h = len;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		h = (h ^ (unsigned long) key[i].type) * 1099511628211UL;
+		h = (h ^ (unsigned long) key[i].sym) * 1099511628211UL;
+		h = (h ^ (unsigned long) key[i].value) * 1099511628211UL;
+	}
+	return h;
+}
+
+/*
+ * Close the declaration slot decl once no value can need it.  The first
+ * expression of its statement may still hoist one into it.
+ */
+static void
+cseclose(long decl)
+{
+	size_t i;
+
+	if (decl < 0 || (csefirst && decl == csedecl()))
+		return;
+	for (i = 0; i < ncses; i++) {
+		if (cses[i].decl == decl)
+			return;
+	}
+	for (i = 0; i < ncsedecls; i++) {
+		if (csedecls[i] == decl)
+			csedecls[i] = -1;
+	}
+	cg_close(decl, 1);
+}
+
+static void
+csekill(size_t i)
+{
+	struct cse *e = &cses[i];
+	long decl = e->decl;
+	size_t j;
+
+	if (decl >= 0) {
+		if (e->pending)
+			cg_close(e->b, 0);
+		if (e->uses > 0) {
+			cg_csetemp(e->a, decl);
+			optstats.temps++;
+		}
+		cg_close(e->a, 1);
+	}
+	for (j = 0; j < e->len; j++) {
+		if (e->key[j].sym != NULL)
+			e->key[j].sym->cses--;
+	}
+	free(e->key);
+	ncses--;
+	memmove(e, e + 1, (ncses - i) * sizeof(*e));
+	cseclose(decl);
+}
+
+static long
+cseat(long a)
+{
+	size_t i;
+
+	for (i = 0; i < ncses; i++) {
+		if (cses[i].a == a)
+			return i;
+	}
+	return -1;
+}
+
+static long
+csefind(const struct csetok *key, size_t len, unsigned long hash)
+{
+	size_t i, j;
+
+	for (i = 0; i < ncses; i++) {
+		if (cses[i].hash != hash || cses[i].len != len)
+			continue;
+		for (j = 0; j < len; j++) {
+			if (cses[i].key[j].type != key[j].type ||
+			    cses[i].key[j].sym != key[j].sym ||
+			    cses[i].key[j].value != key[j].value)
+				break;
+		}
+		if (j == len)
+			return i;
+	}
+	return -1;
+}
+
+static void
+cseadd(struct paren *p, const struct csetok *key, size_t len,
+    unsigned long hash)
+{
+	struct cse *e;
+	size_t i;
+
+	if (ncses == CSE_MAX)
+		csekill(0);
+	if (csedecl() < 0) {
+		cg_close(p->a, 0);
+		return;
+	}
+
+	e = &cses[ncses++];
+	if ((e->key = malloc(len * sizeof(*key))) == NULL)
+		error("malloc failed");
+	memcpy(e->key, key, len * sizeof(*key));
+	for (i = 0; i < len; i++) {
+		if (key[i].sym != NULL)
+			key[i].sym->cses++;
+	}
+	e->len = len;
+	e->hash = hash;
+	e->a = p->a;
+	e->b = nslots++;
+	e->decl = csedecl();
+	e->stmt = csestmt;
+	e->uses = 0;
+	e->pending = 1;
+	cg_csecopy(e->b, e->a);
+}
+
+/*
+ * Compute the pending value i ahead of its statement instead.  Returns
+ * where it is now.
+ */
+static size_t
+csehoist(size_t i)
+{
+	struct cse *e;
+	long a = cses[i].a, b = cses[i].b;
+	size_t j;
+
+	/* Values inside the first copy go with it. */
+	for (j = ncses; j-- > 0; ) {
+		if (cses[j].decl >= 0 && cses[j].a > a && cses[j].a < b)
+			csekill(j);
+	}
+
+	i = cseat(a);
+	e = &cses[i];
+	cg_csehoist(e->a, e->decl);
+	cg_close(e->b, 0);
+	cg_close(e->a, 1);
+	e->decl = -1;
+	e->pending = 0;
+	optstats.temps++;
+	return i;
+}
+
+/*
+ * Use the value i in place of the copy p.  Uses and values inside the
+ * copy go with it.
+ */
+static void
+csereuse(struct paren *p, size_t i)
+{
+	struct cseuse *u;
+	long a = cses[i].a, j;
+
+	for (; ncseused > 0 && cseused[ncseused - 1].at > p->a; ncseused--) {
+		if ((j = cseat(cseused[ncseused - 1].a)) >= 0)
+			cses[j].uses--;
+		optstats.cse--;
+	}
+	for (j = ncses; j-- > 0; ) {
+		if (cses[j].decl >= 0 && cses[j].a > p->a)
+			csekill(j);
+	}
+
+	cg_cseuse(p->a, a);
+	cses[cseat(a)].uses++;
+	optstats.cse++;
+
+	if (ncseused == cseusecap) {
+		cseusecap = cseusecap ? cseusecap * 2 : 16;
+		cseused = realloc(cseused, cseusecap * sizeof(*cseused));
+		if (cseused == NULL)
+			error("malloc failed");
+	}
+	u = &cseused[ncseused++];
+	u->a = a;
+	u->at = p->a;
+}
+
+static void
+csebegin(struct paren *p)
+{
+
+	csetoken(TOK_LPAREN, NULL, 0);
+	p->a = -1;
+	if (checking || par != NULL)
+		return;
+	p->a = slot();
+	p->key = ncsekeys;
+	p->ops = cseops;
+	p->impure = cseimpure;
+	csedepth++;
+}
+
+/*
+ * Before the closing parenthesis of p.
+ */
+static void
+cseend(struct paren *p)
+{
+	const struct csetok *key;
+	unsigned long hash;
+	size_t len;
+	long i;
+
+	if (p->a < 0) {
+		csetoken(TOK_RPAREN, NULL, 0);
+		return;
+	}
+	csedepth--;
+
+	key = csekeys + p->key;
+	len = ncsekeys - p->key;
+	hash = len > CSE_KEY ? 0 : csehash(key, len);
+	if (p->ops == cseops || p->impure != cseimpure || csecalled ||
+	    len > CSE_KEY)
+		cg_close(p->a, 0);
+	else if ((i = csefind(key, len, hash)) < 0)
+		cseadd(p, key, len, hash);
+	else if (!cses[i].pending)
+		csereuse(p, i);
+	else if (csefirst && cses[i].decl == csedecl())
+		csereuse(p, csehoist(i));
+	else
+		cg_close(p->a, 0);
+
+	if (csedepth == 0)
+		ncsekeys = ncseused = 0;
+	csetoken(TOK_RPAREN, NULL, 0);
+}
+
+/*
+ * Values in the block statements after stmt are out of scope.
+ */
+static void
+cseblockend(size_t stmt)
+{
+
+	while (ncses > 0 && cses[ncses - 1].stmt > stmt)
+		csekill(ncses - 1);
+}
+
+static void statement(void);
+
+/*
+ * A statement of a block, with a slot in front of it for the temporaries
+ * it needs.
+ */
+static void
+blockstatement(void)
+{
+	long decl = -1;
+
+	if (!checking && par == NULL) {
+		if (++csestmt % CSE_WINDOW == 0) {
+			while (ncses > 0)
+				csekill(ncses - 1);
+		}
+		decl = slot();
+	}
+	if (ncsedecls == csedeclcap) {
+		csedeclcap = csedeclcap ? csedeclcap * 2 : 16;
+		csedecls = realloc(csedecls, csedeclcap * sizeof(*csedecls));
+		if (csedecls == NULL)
+			error("malloc failed");
+	}
+	csedecls[ncsedecls++] = decl;
+	csefirst = decl >= 0;
+
+	statement();
+
+	csefirst = 0;
+	cseclose(csedecls[--ncsedecls]);
+}
+
+
+/*
+ * Value ranges.
+ *
+ * Each variable, scalar or array, gathers the values assigned to it:
+ * constants, ranges of the loops around, characters read, and the
+ * values of another variable plus a constant.  Anything else leaves it
+ * a long.  Its values include 0, where globals start.  Once nothing
+ * more can be assigned to it, at the end of the outermost procedure
+ * around it or of the program, an array is declared in the narrowest C
+ * type that holds them, and conditions a range decides become
+ * constants.  A variable reached through a pointer, lifted or in the
+ * context of a समानांतर loop, stays a long.  Arithmetic is still done in
+ * long: an operator whose left operand may be narrower casts its right
+ * one.
+ */
+
+static int shapeval(const struct shape *s, long *v);
+static int span(const struct shape *s, struct shape *r);
+
+static int
+parityof(long v)
+{
+
+	return v & 1 ? 2 : 1;
+}
+
+/*
+ * The parities of v + off, for v of parities p.
+ */
+static int
+shiftparity(int p, long off)
+{
+
+	return off & 1 ? (p & 1) << 1 | (p & 2) >> 1 : p;
+}
+
+/*
+ * An int leaves out INT_MIN, which it could not negate.
+ */
+static int
+typebits(long lo, long hi)
+{
+
+	if (lo >= SCHAR_MIN && hi <= SCHAR_MAX)
+		return 8;
+	if (lo >= SHRT_MIN && hi <= SHRT_MAX)
+		return 16;
+	if (lo > INT_MIN && hi <= INT_MAX)
+		return 32;
+	return 64;
+}
+
+/*
+ * A variable is being declared.  A scalar is a long all the same: in a
+ * register, a narrower one saves nothing and costs a conversion at
+ * every use.
+ */
+static void
+rangeopen(struct symtab *sym)
+{
+
+	if (nrangevars == rangevarcap) {
+		rangevarcap = rangevarcap ? rangevarcap * 2 : 32;
+		rangevars = realloc(rangevars,
+		    rangevarcap * sizeof(*rangevars));
+		if (rangevars == NULL)
+			error("malloc failed");
+	}
+	rangevars[nrangevars++] = sym;
+	if (nopen++ == 0)
+		rangebase = stats.tokens;
+
+	sym->range = RANGE_OPEN;
+	sym->lo = sym->hi = 0;
+	sym->parity = 1;
+	sym->typeslot = slot();
+	if (sym->size)
+		optstats.arrays++;
+	else
+		cg_type(sym->typeslot, 64);
+}
+
+/*
+ * sym may hold any value: declare it a long now.
+ */
+static void
+rangenone(struct symtab *sym)
+{
+
+	if (sym->range != RANGE_OPEN && sym->range != RANGE_SOLVING)
+		return;
+	sym->range = RANGE_NONE;
+	nopen--;
+	if (sym->size)
+		cg_type(sym->typeslot, 64);
+}
+
+static void
+rangeadd(struct symtab *sym, long lo, long hi, int parity)
+{
+
+	if (lo < sym->lo)
+		sym->lo = lo;
+	if (hi > sym->hi)
+		sym->hi = hi;
+	sym->parity |= parity;
+}
+
+/*
+ * sym, a scalar or an array, was assigned a value of shape val (NULL if
+ * unknown).
+ */
+static void
+rangeassign(struct symtab *sym, const struct shape *val)
+{
+	struct shape r;
+	struct copy *c;
+	struct rangedep *d;
+	long v;
+
+	if (sym->range != RANGE_OPEN)
+		return;
+
+	if (val == NULL) {
+		rangenone(sym);
+		return;
+	}
+	if (shapeval(val, &v)) {
+		rangeadd(sym, v, v, parityof(v));
+		return;
+	}
+	if (span(val, &r)) {
+		rangeadd(sym, r.lo, r.hi, r.lo == r.hi ? parityof(r.lo) : 3);
+		if (r.deps == 0)
+			return;
+		if (nrangedeps == rangedepcap) {
+			rangedepcap = rangedepcap ? rangedepcap * 2 : 16;
+			rangedeps = realloc(rangedeps,
+			    rangedepcap * sizeof(*rangedeps));
+			if (rangedeps == NULL)
+				error("malloc failed");
+		}
+		d = &rangedeps[nrangedeps++];
+		d->sym = sym;
+		d->deps = r.deps;
+		return;
+	}
+	if (val->kind != SHAPE_VAR || val->sym->range == RANGE_NONE ||
+	    (val->sym == sym && val->off != 0)) {
+		rangenone(sym);
+		return;
+	}
+	if (val->sym == sym)
+		return;
+
+	if (ncopies == copycap) {
+		copycap = copycap ? copycap * 2 : 32;
+		if ((copies = realloc(copies, copycap * sizeof(*copies))) == NULL)
+			error("malloc failed");
+	}
+	c = &copies[ncopies++];
+	c->to = sym;
+	c->from = val->sym;
+	c->off = val->off;
+}
+
+/*
+ * Loop i ends: values that needed it to stay ok stand or fall.
+ */
+static void
+rangeloop(long i, int ok)
+{
+	struct rangedep *d;
+	size_t j, k;
+
+	if (i >= DEP_BITS)
+		return;
+	for (j = k = 0; j < nrangedeps; j++) {
+		d = &rangedeps[j];
+		if (d->deps & (1UL << i)) {
+			if (!ok)
+				rangenone(d->sym);
+			d->deps &= ~(1UL << i);
+		}
+		if (d->deps != 0 && d->sym->range == RANGE_OPEN)
+			rangedeps[k++] = *d;
+	}
+	nrangedeps = k;
+}
+
+/*
+ * The bounds of side d as they stand, into b.  Returns 0 if it has none.
+ */
+static int
+sidenow(const struct side *d, struct side *b)
+{
+	struct symtab *sym = d->sym;
+	long off = d->off;
+
+	*b = *d;
+	if (sym == NULL)
+		return 1;
+	if (sym->range == RANGE_NONE)
+		return 0;
+	b->sym = NULL;
+	b->off = 0;
+	b->parity = shiftparity(sym->parity, off);
+	return !__builtin_add_overflow(sym->lo, off, &b->lo) &&
+	    !__builtin_add_overflow(sym->hi, off, &b->hi);
+}
+
+/*
+ * Whether the bounds of the sides of f, taken as they are now, decide
+ * it, and to what.
+ */
+static int
+foldtest(const struct fold *f, long *v)
+{
+	struct side a, b;
+
+	if (!sidenow(&f->side[0], &a) || !sidenow(&f->side[1], &b))
+		return 0;
+
+	switch (f->op) {
+	case TOK_ODD:
+		*v = a.parity == 2;
+		return a.parity != 3;
+	case TOK_EQUAL:
+	case TOK_HASH:
+		if (a.hi < b.lo || b.hi < a.lo || !(a.parity & b.parity))
+			*v = 0;
+		else if (a.lo == a.hi && b.lo == b.hi)
+			*v = 1;
+		else
+			return 0;
+		if (f->op == TOK_HASH)
+			*v = !*v;
+		return 1;
+	case TOK_LESSTHAN:
+		*v = a.hi < b.lo;
+		return a.hi < b.lo || a.lo >= b.hi;
+	}
+	*v = a.lo > b.hi;
+	return a.lo > b.hi || a.hi <= b.lo;
+}
+
+
+/*
+ * A condition starts: a slot in front of it, unless it is in a समानांतर
+ * body, which moves out of its function.
+ */
+static long
+foldbegin(void)
+{
+
+	return par == NULL ? slot() : -1;
+}
+
+static int
+foldside(const struct shape *s, struct side *d)
+{
+
+	d->sym = NULL;
+	d->off = 0;
+	if (s->kind == SHAPE_CONST) {
+		d->lo = d->hi = s->off;
+		d->parity = parityof(s->off);
+		return 1;
+	}
+	if (s->kind != SHAPE_VAR || s->sym->range == RANGE_NONE)
+		return 0;
+	d->sym = s->sym;
+	d->off = s->off;
+	return 1;
+}
+
+/*
+ * The condition from slot a has been parsed.  It is kept for deciding
+ * once the ranges are final if, comparing variables plus constants, it
+ * is decided already by the values they have been assigned so far.
+ */
+static void
+foldend(long a)
+{
+	struct fold f;
+	long v;
+
+	if (a < 0)
+		return;
+
+	memset(&f, 0, sizeof(f));
+	f.a = a;
+	f.op = condop;
+	if (!foldside(&cond[0], &f.side[0]) ||
+	    (condop != TOK_ODD && !foldside(&cond[1], &f.side[1])) ||
+	    (f.side[0].sym == NULL && f.side[1].sym == NULL) ||
+	    !foldtest(&f, &v)) {
+		cg_close(a, 0);
+		return;
+	}
+
+	if (nfolds == foldcap) {
+		foldcap = foldcap ? foldcap * 2 : 16;
+		if ((folds = realloc(folds, foldcap * sizeof(*folds))) == NULL)
+			error("malloc failed");
+	}
+	f.b = nslots++;
+	cg_condend(f.b, a);
+	folds[nfolds++] = f;
+}
+
+/*
+ * Decide the conditions whose sides are all final.
+ */
+static void
+foldsettle(void)
+{
+	struct fold *f;
+	struct side *d;
+	size_t i, j, k;
+	long v;
+	int open, none;
+
+	for (i = k = 0; i < nfolds; i++) {
+		f = &folds[i];
+		open = none = 0;
+		for (j = 0; j < 2; j++) {
+			d = &f->side[j];
+			if (d->sym == NULL)
+				continue;
+			if (d->sym->range == RANGE_OPEN)
+				open = 1;
+			else if (!sidenow(d, d))
+				none = 1;
+		}
+		if (open && !none) {
+			folds[k++] = *f;
+			continue;
+		}
+		if (!none && foldtest(f, &v)) {
+			cg_fold(f->a, v);
+			optstats.folded++;
+		} else
+			none = 1;
+		cg_close(f->a, !none);
+		cg_close(f->b, 0);
+	}
+	nfolds = k;
+}
+
+/*
+ * Nothing more can be assigned to the open variables of procedures, or
+ * to all of them: solve for the values they copy from each other, and
+ * declare them.
+ */
+static void
+rangedecide(int all)
+{
+	struct symtab *sym;
+	struct copy *c;
+	size_t i, k, round;
+	long lo, hi;
+	int changed, p, bits;
+
+	for (i = 0; i < nrangevars; i++) {
+		sym = rangevars[i];
+		if (sym->range == RANGE_OPEN && (all || sym->owner != NULL))
+			sym->range = RANGE_SOLVING;
+	}
+
+	for (round = 0; ; round++) {
+		changed = 0;
+		for (i = 0; i < ncopies; i++) {
+			c = &copies[i];
+			if (c->to->range != RANGE_SOLVING)
+				continue;
+			if (c->from->range != RANGE_SOLVING ||
+			    __builtin_add_overflow(c->from->lo, c->off, &lo) ||
+			    __builtin_add_overflow(c->from->hi, c->off, &hi)) {
+				rangenone(c->to);
+				changed = 1;
+				continue;
+			}
+			p = shiftparity(c->from->parity, c->off);
+			if (lo >= c->to->lo && hi <= c->to->hi &&
+			    !(p & ~c->to->parity))
+				continue;
+			if (round < RANGE_ROUNDS)
+				rangeadd(c->to, lo, hi, p);
+			else
+				rangenone(c->to);
+			changed = 1;
+		}
+		if (!changed)
+			break;
+	}
+
+	for (i = 0; i < nrangevars; i++) {
+		sym = rangevars[i];
+		if (sym->range != RANGE_SOLVING)
+			continue;
+		sym->range = RANGE_FINAL;
+		nopen--;
+		if (!sym->size)
+			continue;
+		if ((bits = typebits(sym->lo, sym->hi)) < 64)
+			optstats.narrowed++;
+		cg_type(sym->typeslot, bits);
+	}
+
+	/* What is still open keeps only what it waits on. */
+	for (i = k = 0; i < ncopies; i++) {
+		c = &copies[i];
+		if (c->to->range != RANGE_OPEN)
+			continue;
+		if (c->from->range == RANGE_OPEN)
+			copies[k++] = *c;
+		else if (c->from->range == RANGE_NONE ||
+		    __builtin_add_overflow(c->from->lo, c->off, &lo) ||
+		    __builtin_add_overflow(c->from->hi, c->off, &hi))
+			rangenone(c->to);
+		else
+			rangeadd(c->to, lo, hi,
+			    shiftparity(c->from->parity, c->off));
+	}
+	ncopies = k;
+	for (i = k = 0; i < nrangedeps; i++) {
+		if (rangedeps[i].sym->range == RANGE_OPEN)
+			rangedeps[k++] = rangedeps[i];
+	}
+	nrangedeps = k;
+
+	foldsettle();
+
+	for (i = k = 0; i < nrangevars; i++) {
+		if (rangevars[i]->range == RANGE_OPEN)
+			rangevars[k++] = rangevars[i];
+	}
+	nrangevars = k;
+}
+
+/*
+ * Held output is bounded: variables open for RANGE_WINDOW tokens stay
+ * longs, and their conditions as they are.
+ */
+static void
+rangewindow(void)
+{
+	size_t i;
+
+	if (nopen == 0 || stats.tokens - rangebase < RANGE_WINDOW)
+		return;
+
+	for (i = 0; i < nrangevars; i++)
+		rangenone(rangevars[i]);
+	for (i = 0; i < nfolds; i++) {
+		cg_close(folds[i].a, 0);
+		cg_close(folds[i].b, 0);
+	}
+	nrangevars = ncopies = nrangedeps = nfolds = 0;
+}
+
+/*
+ * Before the right operand of an operator whose left one may not be a
+ * long: cast it, unless both are numbers.
+ */
+static int
+widen(int left, const struct shape *s)
+{
+
+	if (left || (s->kind == SHAPE_CONST && type == TOK_NUMBER))
+		return 0;
+	cg_cast();
+	return 1;
+}
+
+
+/*
+ * Bounds checks.
+ *
+ * Every subscript is checked unless its index is a constant, a variable
+ * with a known value, or the variable of an enclosing "v < n" loop (plus
+ * a constant) that provably stays in range.  Loop sites are decided when
+ * the loop ends, since a later assignment in the body can spoil them;
+ * known values wait for the end of the statement, for the same reason.
+ * An index computed from several loop variables waits for each loop in
+ * turn, innermost first.
+ */
+
+/*
+ * Variable values known from straight-line assignments are dropped
+ * wherever control flow joins, and so are common subexpressions.
+ */
+static void
+forget(void)
+{
+	struct symtab *curr;
+
+	for (curr = head; curr != NULL; curr = curr->next) {
+		if (curr->type == TOK_VAR)
+			curr->known = 0;
+	}
+
+	while (ncses > 0)
+		csekill(ncses - 1);
+}
+
+static struct site *
+site(size_t id)
+{
+
+	return &sites[id - sitebase];
+}
+
+static void
+resolve(size_t id, int checked)
+{
+	struct site *s = site(id);
+
+	s->loop = -1;
+	cg_close(s->open, checked);
+	if (s->arith)
+		cg_close(s->open + 1, !checked);
+	cg_close(s->close, checked);
+
+	if (--sitepending == 0 && nloops == 0)
+		sitebase = nsites;
+}
+
+static size_t
+newsite(long size)
+{
+	struct site *s;
+
+	if (nsites - sitebase == sitecap) {
+		sitecap = sitecap ? sitecap * 2 : 64;
+		if ((sites = realloc(sites, sitecap * sizeof(*sites))) == NULL)
+			error("malloc failed");
+	}
+
+	s = &sites[nsites - sitebase];
+	s->loop = -1;
+	s->size = size;
+	s->open = nslots++;
+	s->close = -1;
+	s->safe = 0;
+	s->arith = 0;
+	s->deps = 0;
+	if (sitepending++ == 0)
+		sitetoken = stats.tokens;
+
+	return nsites++;
+}
+
+/*
+ * A site that is safe as long as the loops in deps stay ok.
+ */
+static void
+defer(size_t id, unsigned long deps)
+{
+	struct site *s = site(id);
+
+	if (deps == 0) {
+		resolve(id, 0);
+		return;
+	}
+	s->loop = DEP_BITS - 1 - __builtin_clzl(deps);
+	s->deps = deps & ~(1UL << s->loop);
+	s->safe = 1;
+}
+
+/*
+ * Decide a site now if possible, else leave it to its loop.
+ */
+static void
+checksite(size_t id, const struct shape *idx)
+{
+	struct site *s = site(id);
+	struct loop *l;
+	size_t i;
+	long v;
+
+	if (idx->kind == SHAPE_CONST ||
+	    (idx->kind == SHAPE_VAR && idx->sym->known)) {
+		v = idx->off;
+		if (idx->kind == SHAPE_VAR &&
+		    __builtin_add_overflow(idx->sym->value, idx->off, &v)) {
+			resolve(id, 1);
+			return;
+		}
+		if (v < 0 || v >= s->size)
+			error("index %ld out of bounds [0, %ld)", v, s->size);
+		if (idx->kind == SHAPE_CONST) {
+			resolve(id, 0);
+			return;
+		}
+		s->loop = SITE_STMT;
+		s->safe = 1;
+		return;
+	}
+
+	if (idx->kind == SHAPE_RANGE) {
+		if (idx->lo < 0 || idx->hi >= s->size)
+			resolve(id, 1);
+		else
+			defer(id, idx->deps);
+		return;
+	}
+
+	if (idx->kind == SHAPE_VAR) {
+		for (i = nloops; i-- > 0; ) {
+			l = &loops[i];
+			if (l->sym != idx->sym)
+				continue;
+			if (!l->ok || l->modified ||
+			    __builtin_add_overflow(l->lo, idx->off, &v) ||
+			    v < 0 ||
+			    __builtin_add_overflow(l->hi, idx->off, &v) ||
+			    v >= s->size)
+				break;
+			s->loop = i;
+			s->off = idx->off;
+			s->safe = 1;
+			return;
+		}
+	}
+
+	resolve(id, 1);
+}
+
+/*
+ * sym was assigned a value of shape val (NULL if unknown).
+ */
+static void
+assigned(struct symtab *sym, const struct shape *val)
+{
+	struct loop *l;
+	size_t i, j;
+	int known = 0;
+	long v = 0;
+
+	for (i = 0; i < nloops; i++) {
+		l = &loops[i];
+		if (l->sym != sym)
+			continue;
+
+		l->modified = 1;
+		if (val == NULL ||
+		    !((val->kind == SHAPE_VAR && val->sym == sym &&
+		    val->off >= 0) ||
+		    (val->kind == SHAPE_CONST && val->off >= l->lo)))
+			l->ok = 0;
+
+		/* Inside a nested loop the back edge reaches earlier sites. */
+		if (i + 1 < nloops) {
+			j = loops[i + 1].firstsite;
+			for (j = j > sitebase ? j : sitebase; j < nsites; j++) {
+				if (site(j)->loop == (long) i ||
+				    (site(j)->deps & (1UL << i)))
+					site(j)->safe = 0;
+			}
+		}
+	}
+
+	if (val != NULL && val->kind == SHAPE_CONST) {
+		known = 1;
+		v = val->off;
+	} else if (val != NULL && val->kind == SHAPE_VAR && val->sym->known) {
+		known = !__builtin_add_overflow(val->sym->value, val->off, &v);
+	}
+	sym->known = known;
+	sym->value = v;
+
+	for (i = ncses; sym->cses > 0 && i-- > 0; ) {
+		for (j = 0; j < cses[i].len; j++) {
+			if (cses[i].key[j].sym == sym) {
+				csekill(i);
+				break;
+			}
+		}
+	}
+
+	rangeassign(sym, val);
+}
+
+/*
+ * A procedure call may assign any variable, even one indexed earlier in
+ * the same statement: C leaves the order of the two open.
+ */
+static void
+clobbered(void)
+{
+	size_t i;
+
+	for (i = 0; i < nloops; i++)
+		loops[i].ok = 0;
+
+	for (i = stmtfirst > sitebase ? stmtfirst : sitebase; i < nsites; i++) {
+		if (site(i)->loop == SITE_STMT)
+			site(i)->safe = 0;
+	}
+
+	/*
+	 * Nothing computed after the call can move ahead of it, nor be kept
+	 * for later statements: C may still compute it before the call.
+	 */
+	csefirst = 0;
+	csecalled = 1;
+	forget();
+}
+
+/*
+ * Held output is bounded: प्रत्येक loops open for SITE_WINDOW tokens stay
+ * loops, and sites undecided that long, all of them decided by the end
+ * of a statement, are checked.  The loops around forget them.
+ */
+static void
+sitewindow(void)
+{
+	size_t i;
+
+	if (nfors > 0 && stats.tokens - fortoken >= SITE_WINDOW) {
+		cg_forkeep();
+		fortoken = stats.tokens;
+	}
+
+	if (sitepending == 0 || stats.tokens - sitetoken < SITE_WINDOW)
+		return;
+
+	for (i = sitebase; i < nsites; i++) {
+		if (site(i)->loop != -1)
+			resolve(i, 1);
+	}
+	sitebase = nsites;
+}
+
+static void
+stmtend(void)
+{
+	size_t i;
+
+	for (i = stmtfirst > sitebase ? stmtfirst : sitebase; i < nsites; i++) {
+		if (site(i)->loop == SITE_STMT)
+			resolve(i, !site(i)->safe);
+	}
+
+	for (i = 0; i < ncses; i++) {
+		if (cses[i].pending) {
+			cg_close(cses[i].b, 0);
+			cses[i].pending = 0;
+		}
+	}
+	csefirst = 0;
+	cseclose(csedecl());
+
+	rangewindow();
+	sitewindow();
+}
+
+/*
+ * The bound of a "v < n" condition: n if constant, else LONG_MAX for any
+ * shape whose evaluation cannot call a procedure that changes v.
+ */
+static int
+bounding(const struct shape *s, long *n)
+{
+
+	switch (s->kind) {
+	case SHAPE_CONST:
+		*n = s->off;
+		return 1;
+	case SHAPE_VAR:
+	case SHAPE_RANGE:
+		*n = LONG_MAX;
+		return 1;
+	}
+	return 0;
+}
+
+static void
+pushloop(size_t first)
+{
+	struct symtab *v = NULL;
+	struct loop *l;
+	long n = 0;
+
+	if (nloops == loopcap) {
+		loopcap = loopcap ? loopcap * 2 : 16;
+		if ((loops = realloc(loops, loopcap * sizeof(*loops))) == NULL)
+			error("malloc failed");
+	}
+
+	/* Against a variable n is unknown, but v < n still keeps v + 1 safe. */
+	if (condop == TOK_LESSTHAN && cond[0].kind == SHAPE_VAR &&
+	    cond[0].off == 0 && bounding(&cond[1], &n)) {
+		v = cond[0].sym;
+	} else if (condop == TOK_GREATERTHAN && cond[1].kind == SHAPE_VAR &&
+	    cond[1].off == 0 && bounding(&cond[0], &n)) {
+		v = cond[1].sym;
+	}
+
+	l = &loops[nloops];
+	l->sym = NULL;
+	if (v != NULL && v->type == TOK_VAR && v->size == 0 &&
+	    v->entryknown && n > LONG_MIN) {
+		l->sym = v;
+		l->lo = v->entry;
+		l->hi = n - 1;
+	}
+	l->ok = 1;
+	l->modified = 0;
+	l->firstsite = first > sitebase ? first : sitebase;
+	nloops++;
+}
+
+static void
+poploop(void)
+{
+	struct loop *l = &loops[nloops - 1];
+	struct site *s;
+	size_t i;
+
+	rangeloop(nloops - 1, l->ok);
+
+	i = l->firstsite > sitebase ? l->firstsite : sitebase;
+	for (; i < nsites; i++) {
+		s = site(i);
+		if (s->loop != (long) nloops - 1)
+			continue;
+		if (l->ok && s->safe)
+			defer(i, s->deps);
+		else
+			resolve(i, 1);
+	}
+
+	if (--nloops == 0 && sitepending == 0)
+		sitebase = nsites;
+
+	forget();
+}
+
+/*
+ * A loop whose variable sym is in [lo, hi] throughout its body, as the
+ * body never assigns it.
+ */
+static void
+pushrange(struct symtab *sym, long lo, long hi)
 {
-	aout(L"const long %s=", get(map,token));
+	struct loop *l;
+
+	if (nloops == loopcap) {
+		loopcap = loopcap ? loopcap * 2 : 16;
+		if ((loops = realloc(loops, loopcap * sizeof(*loops))) == NULL)
+			error("malloc failed");
+	}
+	l = &loops[nloops++];
+	l->sym = sym;
+	l->lo = lo;
+	l->hi = hi;
+	l->ok = 1;
+	l->modified = 0;
+	l->firstsite = nsites;
 }
 
+/*
+ * Remember which variables are known on entry to a loop, then forget
+ * them: the condition and body also run after later iterations.
+ */
 static void
-cg_semicolon(void)
+enterloop(void)
 {
+	struct symtab *curr;
 
-	aout(L";\n");
+	for (curr = head; curr != NULL; curr = curr->next) {
+		curr->entryknown = curr->type == TOK_VAR && curr->known;
+		curr->entry = curr->value;
+	}
+
+	forget();
+}
+
+/*
+ * Output slots, numbered in the order they are opened.
+ */
+
+static long
+slot(void)
+{
+
+	cg_slot(nslots);
+	return nslots++;
+}
+
+/*
+ * Tasks.
+ *
+ * A समवर्ती call runs alongside the rest of the calling function until
+ * a प्रतीक्षा, a लौटाओ or the function's end joins it.  Every procedure
+ * gathers the variables of others it reads and writes, through the
+ * procedures it calls too; a scalar one task writes must not otherwise be
+ * used by anything running alongside it, and an array only draws a
+ * warning, as the elements used may differ.
+ */
+
+/*
+ * Add to u; returns whether that is news.
+ */
+static int
+use(struct uses *u, struct symtab *sym, struct proc *p, int how)
+{
+	struct use *e;
+	size_t i;
+
+	for (i = 0; i < u->n; i++) {
+		e = &u->v[i];
+		if (e->sym != sym || e->proc != p)
+			continue;
+		if ((e->how | how) == e->how)
+			return 0;
+		e->how |= how;
+		return 1;
+	}
+
+	if (u->n == u->cap) {
+		u->cap = u->cap ? u->cap * 2 : 8;
+		if ((u->v = realloc(u->v, u->cap * sizeof(*u->v))) == NULL)
+			error("malloc failed");
+	}
+	e = &u->v[u->n++];
+	e->sym = sym;
+	e->proc = p;
+	e->how = how;
+
+	return 1;
 }
 
 static void
-cg_symbol(void)
+record(struct symtab *sym, struct proc *p, int how)
 {
-	switch (type) {
-	case TOK_IDENT:
-		aout(L"%s", get(map,token));
-		break;
-	case TOK_NUMBER:
-		aout(L"%ls", token);
-		break;
-	case TOK_BEGIN:
-		aout(L"{");
-		break;
-	case TOK_END:
-		aout(L";}\n");
-		break;
-	case TOK_IF:
-		aout(L"if(");
-		break;
-	case TOK_THEN:
-	case TOK_DO:
-		aout(L")");
-		break;
-	case TOK_ODD:
-		aout(L"(");
-		break;
-	case TOK_WHILE:
-		aout(L"while(");
-		break;
-	case TOK_EQUAL:
-		aout(L"==");
-		break;
-	case TOK_COMMA:
-		aout(L",");
-		break;
-	case TOK_ASSIGN:
-		aout(L"=");
-		break;
-	case TOK_HASH:
-		aout(L"!=");
-		break;
-	case TOK_LESSTHAN:
-		aout(L"<");
-		break;
-	case TOK_GREATERTHAN:
-		aout(L">");
-		break;
-	case TOK_PLUS:
-		aout(L"+");
-		break;
-	case TOK_MINUS:
-		aout(L"-");
-		break;
-	case TOK_MULTIPLY:
-		aout(L"*");
-		break;
-	case TOK_DIVIDE:
-		aout(L"/");
-		break;
-	case TOK_LPAREN:
-		aout(L"(");
-		break;
-	case TOK_RPAREN:
-		aout(L")");
+	size_t i;
+
+	if (curproc != NULL && (sym == NULL || sym->owner != curproc))
+		use(&curproc->uses, sym, p, how);
+	for (i = 0; i < nrunning; i++)
+		use(&tasks[running[i]].with, sym, p, how);
+	if (ntaskloops > 0)
+		use(&taskloops[ntaskloops - 1], sym, p, how);
+}
+
+static void
+touch(struct symtab *sym, int how)
+{
+
+	if (sym->type == TOK_VAR)
+		record(sym, NULL, how);
+}
+
+static void
+touchcall(struct proc *p)
+{
+
+	record(NULL, p, 0);
+}
+
+static void
+run(size_t t)
+{
+	size_t i;
+
+	for (i = 0; i < nrunning; i++) {
+		if (running[i] == t)
+			return;
+	}
+	if (nrunning == runcap) {
+		runcap = runcap ? runcap * 2 : 16;
+		running = realloc(running, runcap * sizeof(*running));
+		if (running == NULL)
+			error("malloc failed");
+	}
+	running[nrunning++] = t;
+}
+
+/*
+ * Where control flow joins, tasks running on either path may be running.
+ */
+static size_t *
+saverunning(size_t *n)
+{
+	size_t *v;
+
+	if ((*n = nrunning) == 0)
+		return NULL;
+	if ((v = malloc(nrunning * sizeof(*v))) == NULL)
+		error("malloc failed");
+	memcpy(v, running, nrunning * sizeof(*v));
+
+	return v;
+}
+
+static void
+mergerunning(size_t *v, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		run(v[i]);
+	free(v);
+}
+
+static void
+pushtaskloop(void)
+{
+
+	if (ntaskloops == taskloopcap) {
+		taskloopcap = taskloopcap ? taskloopcap * 2 : 8;
+		taskloops = realloc(taskloops, taskloopcap * sizeof(*taskloops));
+		if (taskloops == NULL)
+			error("malloc failed");
+	}
+	memset(&taskloops[ntaskloops++], 0, sizeof(*taskloops));
+}
+
+static void
+poptaskloop(void)
+{
+	struct uses *u = &taskloops[--ntaskloops];
+	size_t i, j;
+
+	for (i = 0; i < u->n; i++) {
+		for (j = 0; j < nrunning; j++)
+			use(&tasks[running[j]].with, u->v[i].sym, u->v[i].proc,
+			    u->v[i].how);
+		if (ntaskloops > 0)
+			use(&taskloops[ntaskloops - 1], u->v[i].sym,
+			    u->v[i].proc, u->v[i].how);
+	}
+	free(u->v);
+}
+
+static void
+joinpoint(int stmt)
+{
+	long s = slot();
+
+	if (njoins == joincap) {
+		joincap = joincap ? joincap * 2 : 16;
+		if ((joins = realloc(joins, joincap * sizeof(*joins))) == NULL)
+			error("malloc failed");
+	}
+	joins[njoins++] = s << 1 | stmt;
+	nrunning = 0;
+}
+
+/*
+ * The function has ended, joining whatever is still running.
+ */
+static void
+endtasks(void)
+{
+	size_t i;
+
+	cg_epilogue(tasking);
+	if (tasking && taskgroup >= 0)
+		cg_group(taskgroup);
+	for (i = 0; i < njoins; i++) {
+		if (tasking)
+			cg_join(joins[i] >> 1, joins[i] & 1);
+		cg_close(joins[i] >> 1, 1);
+	}
+	njoins = 0;
+	nrunning = 0;
+	tasking = 0;
+}
+
+/*
+ * Each procedure of the tree that just ended reaches what it uses, and
+ * what its callees reach that it does not own, until nothing changes.
+ */
+static void
+reachtree(void)
+{
+	struct use *e, *r;
+	struct proc *p;
+	size_t i, j, k;
+	int changed;
+
+	do {
+		changed = 0;
+		for (i = 0; i < nprocs; i++) {
+			p = procs[i];
+			for (j = 0; j < p->uses.n; j++) {
+				e = &p->uses.v[j];
+				if (e->sym != NULL) {
+					changed |= use(&p->reach, e->sym, NULL,
+					    e->how);
+					continue;
+				}
+				for (k = 0; k < e->proc->reach.n; k++) {
+					r = &e->proc->reach.v[k];
+					if (r->sym->owner != p)
+						changed |= use(&p->reach,
+						    r->sym, NULL, r->how);
+				}
+			}
+		}
+	} while (changed);
+}
+
+static int
+touches(const struct uses *u, const struct symtab *sym)
+{
+	const struct use *e;
+	size_t i;
+	int how = 0;
+
+	for (i = 0; i < u->n; i++) {
+		e = &u->v[i];
+		if (e->sym == sym)
+			how |= e->how;
+		else if (e->proc != NULL)
+			how |= touches(&e->proc->reach, sym);
+	}
+
+	return how;
+}
+
+static void
+checktasks(void)
+{
+	struct task *t;
+	struct use *r;
+	size_t i, j, at = line;
+	int how;
+
+	for (i = 0; i < ntasks; i++) {
+		t = &tasks[i];
+		line = t->line;
+		for (j = 0; j < t->callee->reach.n; j++) {
+			r = &t->callee->reach.v[j];
+			how = touches(&t->with, r->sym);
+			if (!(how & USE_WRITE) &&
+			    !((r->how & USE_WRITE) && how))
+				continue;
+			if (r->sym->size == 0)
+				error("%ls races with the समवर्ती call to %ls",
+				    r->sym->name, t->callee->sym->name);
+			warning("elements of %ls may race with the समवर्ती "
+			    "call to %ls", r->sym->name, t->callee->sym->name);
+		}
+		free(t->with.v);
+	}
+	ntasks = 0;
+	line = at;
+}
+
+/*
+ * Memoization (--memo).
+ *
+ * A procedure that does no I/O and runs no tasks, and calls only such
+ * procedures, is a function of its arguments and of the globals it
+ * reaches: given the same ones, it returns the same value and leaves
+ * the globals it writes the same.  A top-level one whose globals are
+ * all scalars, and at most MEMO_KEYS with its arguments, is called
+ * through a cache keyed on them, from the calls after it.
+ */
+
+static void
+impure(void)
+{
+
+	if (curproc != NULL)
+		curproc->impure = 1;
+}
+
+/*
+ * The tree that just ended, after reachtree: which of it is impure, and
+ * whether its top-level procedure is memoized.
+ */
+static void
+memotree(void)
+{
+	struct proc *p, *root = NULL;
+	struct use *e;
+	size_t i, j;
+	int changed;
+
+	do {
+		changed = 0;
+		for (i = 0; i < nprocs; i++) {
+			p = procs[i];
+			for (j = 0; j < p->uses.n && !p->impure; j++) {
+				e = &p->uses.v[j];
+				if (e->proc != NULL && e->proc->impure) {
+					p->impure = 1;
+					changed = 1;
+				}
+			}
+		}
+	} while (changed);
+
+	for (i = 0; i < nprocs; i++) {
+		if (procs[i]->parent == NULL)
+			root = procs[i];
+	}
+	if (root == NULL)
+		return;
+	optstats.procs++;
+	if (root->impure || root->nparams + root->reach.n > MEMO_KEYS)
+		return;
+	for (i = 0; i < root->reach.n; i++) {
+		if (root->reach.v[i].sym->size)
+			return;
+	}
+
+	root->memo = 1;
+	optstats.memo++;
+	cg_memo(root->sym->id, root->nparams);
+	for (i = 0; i < root->reach.n; i++) {
+		e = &root->reach.v[i];
+		cg_memovar(e->sym->id, (e->how & USE_WRITE) != 0);
+	}
+}
+
+static void
+addthunk(struct proc *p)
+{
+	struct thunk *t;
+
+	if (nthunks == thunkcap) {
+		thunkcap = thunkcap ? thunkcap * 2 : 8;
+		thunks = realloc(thunks, thunkcap * sizeof(*thunks));
+		if (thunks == NULL)
+			error("malloc failed");
+	}
+	t = &thunks[nthunks++];
+	t->id = p->sym->id;
+	t->num = p->num;
+	t->nparams = p->nparams;
+	t->nlifted = p->nlifted;
+}
+
+/*
+ * After the program, the scheduler and the entries of the procedures it
+ * runs.
+ */
+static void
+emitthunks(void)
+{
+	struct thunk *t;
+	size_t i;
+
+	if (nthunks == 0)
+		return;
+
+	cg_tasks();
+	for (i = 0; i < nthunks; i++) {
+		t = &thunks[i];
+		cg_thunk(t->id, t->num, t->nparams);
+		cg_endthunk(t->nparams + 1, t->nlifted);
+	}
+	free(thunks);
+}
+
+/*
+ * Lambda lifting.
+ */
+
+/*
+ * p uses v, declared in a procedure around it.  Returns whether v is new
+ * to p.
+ */
+static int
+lift(struct proc *p, struct symtab *v)
+{
+	size_t i;
+
+	if (p == NULL || v->type != TOK_VAR || v->owner == NULL ||
+	    v->owner == p)
+		return 0;
+
+	for (i = 0; i < p->nlifted; i++) {
+		if (p->lifted[i] == v)
+			return 0;
+		if (p->lifted[i]->name == v->name)
+			error("%ls is hidden in %ls but needed by a procedure "
+			    "it calls", v->name, p->sym->name);
+	}
+	for (i = 0; i < p->nown; i++) {
+		if (p->own[i]->name == v->name)
+			error("%ls is hidden in %ls but needed by a procedure "
+			    "it calls", v->name, p->sym->name);
+	}
+
+	if (p->nlifted == p->liftcap) {
+		p->liftcap = p->liftcap ? p->liftcap * 2 : 8;
+		p->lifted = realloc(p->lifted, p->liftcap * sizeof(*p->lifted));
+		if (p->lifted == NULL)
+			error("malloc failed");
+	}
+	p->lifted[p->nlifted++] = v;
+
+	return 1;
+}
+
+static struct proc *
+newproc(struct symtab *sym)
+{
+	struct proc *p;
+
+	if ((p = calloc(1, sizeof(*p))) == NULL)
+		error("malloc failed");
+	p->sym = sym;
+	p->parent = curproc;
+	p->num = curproc ? ++nested : 0;
+	sym->proc = p;
+
+	if (nprocs == proccap) {
+		proccap = proccap ? proccap * 2 : 16;
+		if ((procs = realloc(procs, proccap * sizeof(*procs))) == NULL)
+			error("malloc failed");
+	}
+	procs[nprocs++] = p;
+
+	return p;
+}
+
+/*
+ * A call from the current procedure to p, nested in some other
+ * procedure, leaves a slot for p's lifted variables.
+ */
+static void
+addcall(struct proc *p, int spawn)
+{
+	struct call *c;
+
+	if (ncalls == callcap) {
+		callcap = callcap ? callcap * 2 : 16;
+		if ((calls = realloc(calls, callcap * sizeof(*calls))) == NULL)
+			error("malloc failed");
+	}
+	c = &calls[ncalls++];
+	c->caller = curproc;
+	c->callee = p;
+	c->slot = slot();
+	c->spawn = spawn;
+}
+
+/*
+ * Spell p's lifted variables into a slot.  Arrays are passed as they
+ * are; scalars by address, and dereferenced by a macro inside p.
+ */
+static void
+liftinto(long id, struct proc *p, int how, int comma)
+{
+	struct symtab *v;
+	size_t i;
+	int kind;
+
+	for (i = 0; i < p->nlifted; i++) {
+		v = p->lifted[i];
+		if (how == LIFT_DEFINE || how == LIFT_UNDEF) {
+			if (!v->size)
+				cg_lift(id, how, v->id);
+			continue;
+		}
+		kind = how & ~LIFT_LONG;
+		if (kind == LIFT_ADDR && v->size)
+			kind = LIFT_ARG;
+		cg_lift(id, kind | (how & LIFT_LONG) |
+		    (comma || i ? LIFT_COMMA : 0), v->id);
+	}
+}
+
+/*
+ * The outermost procedure has ended: a caller lifts whatever its callees
+ * lift that it does not own, until nothing changes.  Then fill and
+ * close every slot left open since it began, and check its tasks.
+ */
+static void
+lifttree(void)
+{
+	struct symtab *sym;
+	struct proc *p;
+	struct call *c;
+	size_t i, j;
+	int changed;
+
+	do {
+		changed = 0;
+		for (i = 0; i < ncalls; i++) {
+			c = &calls[i];
+			for (j = 0; j < c->callee->nlifted; j++) {
+				if (c->callee->lifted[j]->owner != c->caller &&
+				    lift(c->caller, c->callee->lifted[j]))
+					changed = 1;
+			}
+		}
+	} while (changed);
+
+	for (i = 0; i < nprocs; i++) {
+		for (j = 0; j < procs[i]->nlifted; j++)
+			rangenone(procs[i]->lifted[j]);
+	}
+	rangedecide(0);
+
+	for (i = 0; i < ncalls; i++) {
+		c = &calls[i];
+		if (c->spawn)
+			liftinto(c->slot, c->callee, LIFT_ADDR | LIFT_LONG, 1);
+		else
+			liftinto(c->slot, c->callee, LIFT_ADDR,
+			    c->callee->nparams > 0);
+		cg_close(c->slot, 1);
+	}
+	ncalls = 0;
+
+	reachtree();
+	checktasks();
+	if (memoizing)
+		memotree();
+
+	for (i = 0; i < nprocs; i++) {
+		p = procs[i];
+		if (p->parent != NULL) {
+			liftinto(p->proto, p, LIFT_PROTO, p->nparams > 0);
+			liftinto(p->params, p, LIFT_PARAM, p->nparams > 0);
+			liftinto(p->defs, p, LIFT_DEFINE, 0);
+			liftinto(p->undefs, p, LIFT_UNDEF, 0);
+			cg_close(p->proto, 1);
+			cg_close(p->params, 1);
+			cg_close(p->undefs, 1);
+		}
+		if (p->tail)
+			cg_tail(p->defs);
+		cg_close(p->defs, 1);
+		if (p->spawned && p->parent != NULL)
+			addthunk(p);
+		free(p->own);
+		free(p->lifted);
+		free(p->uses.v);
+		memset(&p->uses, 0, sizeof(p->uses));
+		if (p->parent != NULL) {
+			free(p->reach.v);
+			free(p);
+		} else {
+			p->own = p->lifted = NULL;
+			p->nown = p->owncap = 0;
+		}
+	}
+	nprocs = 0;
+
+	while ((sym = graveyard) != NULL) {
+		graveyard = sym->next;
+		free(sym);
 	}
 }
 
+/*
+ * Parallel loops.
+ *
+ * A समानांतर body may read any scalar, and may write one only if it is a
+ * reduction or its first use in the body is an unconditional assignment,
+ * which makes it private to each iteration.  An array it writes must
+ * only be indexed at the loop variable plus one same constant.  Calls,
+ * input and output are not allowed in it.
+ */
+
 static void
-cg_crlf(void)
+parread(struct symtab *sym)
 {
 
-	aout(L"\n");
+	if (par == NULL || sym->type != TOK_VAR || sym == par->index)
+		return;
+	if (sym->paruse & PAR_REDUCE)
+		error("reduction variable %ls must only be added to",
+		    sym->name);
+	if (!(sym->paruse & PAR_PRIVATE))
+		sym->paruse |= PAR_READ;
 }
 
 static void
-cg_var(void)
+parassign(struct symtab *sym)
 {
 
-	aout(L"long %hs;\n", get(map,token));
+	if (par == NULL || (sym->paruse & (PAR_PRIVATE | PAR_REDUCE)))
+		return;
+	if (sym == par->index)
+		error("समानांतर loop variable %ls is assigned", sym->name);
+	if ((sym->paruse & PAR_READ) || par->depth > 0)
+		error("%ls is shared by the iterations of a समानांतर loop",
+		    sym->name);
+	sym->paruse |= PAR_PRIVATE;
 }
 
 static void
-cg_procedure(void)
+parindex(struct symtab *sym, const struct shape *idx, int write)
 {
-    if (proc == 0) {
-        aout(L"int\n");
-        aout(L"main(int argc, char *argv[])\n");
-        aout(L"{\n");
-        aout(L"    setlocale(LC_ALL, \"en_US.UTF-8\");\n");
-    } else {
-        aout(L"void\n");
-        aout(L"%s(void)\n", get(map,token));
-        aout(L"{\n");
-    }
+
+	if (par == NULL)
+		return;
+	if (write)
+		sym->paruse |= PAR_WRITE;
+	if (idx->kind != SHAPE_VAR || idx->sym != par->index ||
+	    ((sym->paruse & PAR_INDEXED) && sym->paroff != idx->off)) {
+		sym->paruse |= PAR_IRREGULAR;
+	} else {
+		sym->paruse |= PAR_INDEXED;
+		sym->paroff = idx->off;
+	}
+	if ((sym->paruse & PAR_WRITE) && (sym->paruse & PAR_IRREGULAR))
+		error("iterations of a समानांतर loop share elements of %ls",
+		    sym->name);
 }
 
 static void
-cg_epilogue(void)
+parforbid(const char *what)
 {
 
-	aout(L";");
+	if (par != NULL)
+		error("%s inside a समानांतर loop", what);
+}
 
-	if (proc == 0)
-		aout(L"return 0;");
+/*
+ * How the body reaches v: its own copy (private or reduction), through
+ * the context array, or directly as a global.
+ */
+static int
+parrole(struct symtab *v)
+{
 
-	aout(L"\n}\n\n");
+	if (v->type != TOK_VAR || v->paruse == 0 || v == par->index)
+		return 0;
+	if (v->paruse & PAR_REDUCE)
+		return DECL_ZERO;
+	if (v->paruse & PAR_PRIVATE)
+		return DECL_LOCAL;
+	if (v->owner == NULL)
+		return 0;
+	return v->size ? DECL_ARRAY : DECL_SHARED;
 }
 
-static void
-cg_readchar(void)
+/*
+ * A bound, if it is known.
+ */
+static int
+shapeval(const struct shape *s, long *v)
 {
-    aout(L"wint_t __wch = fgetwc(stdin);\n");
-    aout(L"if (__wch == WEOF) {\n");
-    aout(L"    /* treat EOF as -1 or handle error */\n");
-    aout(L"    (void) fprintf(stderr, \"unexpected EOF when reading character\\n\");\n");
-    aout(L"    exit(1);\n");
-    aout(L"}\n");
-    aout(L"%s = (long) __wch;\n", get(map,token));
+
+	if (s->kind == SHAPE_CONST) {
+		*v = s->off;
+		return 1;
+	}
+	if (s->kind == SHAPE_VAR && s->sym->known)
+		return !__builtin_add_overflow(s->sym->value, s->off, v);
+	return 0;
 }
 
-static void
-cg_call(void)
+/*
+ * The range of s as a SHAPE_RANGE in r, if it has one: a constant, or
+ * the variable of an enclosing loop with known bounds, plus a constant.
+ */
+static int
+span(const struct shape *s, struct shape *r)
+{
+	struct loop *l;
+	size_t i;
+
+	r->kind = SHAPE_RANGE;
+	r->deps = 0;
+	switch (s->kind) {
+	case SHAPE_CONST:
+		r->lo = r->hi = s->off;
+		return 1;
+	case SHAPE_RANGE:
+		*r = *s;
+		return 1;
+	case SHAPE_VAR:
+		for (i = nloops; i-- > 0; ) {
+			l = &loops[i];
+			if (l->sym != s->sym)
+				continue;
+			if (!l->ok || l->modified || i >= (size_t) DEP_BITS)
+				return 0;
+			r->deps = 1UL << i;
+			return !__builtin_add_overflow(l->lo, s->off, &r->lo) &&
+			    !__builtin_add_overflow(l->hi, s->off, &r->hi);
+		}
+	}
+	return 0;
+}
+
+/*
+ * Apply op to the ranges a and b, into a, unless it may overflow or
+ * divide by 0 somewhere in them.  The extremes are at the corners, as b
+ * does not straddle 0 for a division.
+ */
+static int
+rangeop(struct shape *a, int op, const struct shape *b)
 {
+	long l, r, v, lo = 0, hi = 0;
+	int i;
+
+	if (op == TOK_DIVIDE && ((b->lo <= 0 && b->hi >= 0) ||
+	    (a->lo == LONG_MIN && b->lo <= -1 && b->hi >= -1)))
+		return 0;
+
+	for (i = 0; i < 4; i++) {
+		l = i & 1 ? a->hi : a->lo;
+		r = i & 2 ? b->hi : b->lo;
+		switch (op) {
+		case TOK_PLUS:
+			if (__builtin_add_overflow(l, r, &v))
+				return 0;
+			break;
+		case TOK_MINUS:
+			if (__builtin_sub_overflow(l, r, &v))
+				return 0;
+			break;
+		case TOK_MULTIPLY:
+			if (__builtin_mul_overflow(l, r, &v))
+				return 0;
+			break;
+		default:
+			v = l / r;
+		}
+		if (i == 0 || v < lo)
+			lo = v;
+		if (i == 0 || v > hi)
+			hi = v;
+	}
 
-	aout(L"%s();\n", get(map,token));
+	a->lo = lo;
+	a->hi = hi;
+	a->deps |= b->deps;
+	return 1;
 }
 
+/*
+ * Parser.
+ */
+
 static void
-cg_odd(void)
+next(void)
 {
+	struct tokrec t;
+	int ph;
+
+	if (pipelined)
+		ring_get(&t);
+	else {
+		ph = enter(PH_LEX);
+		if (inp != NULL)
+			tokin(&t);
+		else
+			lextok(&t);
+		enter(ph);
+	}
 
-	aout(L")&1");
+	type = t.type;
+	line = t.line;
+	stats.tokens++;
+	if (type == TOK_IDENT)
+		stats.idents++;
+
+	switch (type) {
+	case TOK_IDENT:
+		tokid = t.u.id;
+		token = tokid->key;
+		break;
+	case TOK_NUMBER:
+		tokval = t.u.value;
+		break;
+	case TOK_ERROR:
+		error("%s", t.u.msg);
+	}
 }
 
 static void
-cg_writechar(int isIdent)
+expect(int match)
 {
-	if(isIdent)
-		aout(L"wprintf(L\"%%lc\", (wint_t) %s);", get(map,token));
-	else    
-		aout(L"wprintf(L\"%%lc\", (wint_t) %ls);", token);
 
+	if (match != type)
+		error("syntax error");
+
+	next();
 }
 
+static void term(void);
+
+/*
+ * Fold a + or - of two shapes into the first.
+ */
 static void
-cg_readint(void)
+combine(struct shape *a, int op, const struct shape *b)
 {
-    /* Portable integer input using strtoll */
-    aout(L"char __stdin[64];\n");
-    aout(L"char *endptr;\n");
-    aout(L"long long __val_ll;\n");
-    aout(L"if (!fgets(__stdin, sizeof(__stdin), stdin)) { perror(\"fgets\"); exit(1); }\n");
-    aout(L"if(__stdin[strlen(__stdin) - 1] == '\\n') __stdin[strlen(__stdin) - 1] = '\\0';\n");
-    aout(L"errno = 0;\n");
-    aout(L"__val_ll = strtoll(__stdin, &endptr, 10);\n");
-    aout(L"if (endptr == __stdin || *endptr != '\\0' || (errno == ERANGE && (__val_ll == LLONG_MAX || __val_ll == LLONG_MIN))) {\n");
-    aout(L"    (void) fprintf(stderr, \"invalid number: %%s\\n\", __stdin);\n");
-    aout(L"    exit(1);\n");
-    aout(L"}\n");
-    aout(L"%s = (long) __val_ll;\n", get(map,token));
+	long off = b->off;
+
+	if (op == TOK_MINUS) {
+		if (b->kind != SHAPE_CONST || off == LONG_MIN) {
+			a->kind = SHAPE_OTHER;
+			return;
+		}
+		off = -off;
+	}
+
+	if (a->kind == SHAPE_CONST && b->kind == SHAPE_VAR && op == TOK_PLUS)
+		a->sym = b->sym;
+	else if (b->kind != SHAPE_CONST ||
+	    (a->kind != SHAPE_CONST && a->kind != SHAPE_VAR)) {
+		a->kind = SHAPE_OTHER;
+		return;
+	}
+
+	if (__builtin_add_overflow(a->off, off, &a->off))
+		a->kind = SHAPE_OTHER;
+	else if (b->kind == SHAPE_VAR)
+		a->kind = SHAPE_VAR;
 }
 
-static void
-cg_writeint(int isIdent)
-{	
-	if(isIdent)
-		aout(L"(void) fprintf(stdout, \"%%ld\", (long) %s);", get(map,token));
+/*
+ * Fold an operator into a, and return whether the ranges of the operands
+ * rule out overflow and division by 0, and on which loops that depends.
+ */
+static int
+fold(struct shape *a, int op, const struct shape *b, unsigned long *deps)
+{
+	struct shape x, y;
+	int ranged, safe;
+
+	ranged = span(a, &x) && span(b, &y) && rangeop(&x, op, &y);
+	safe = ranged;
+	*deps = ranged ? x.deps : 0;
+	if (!ranged && op == TOK_DIVIDE && span(b, &y) &&
+	    (y.lo > 0 || y.hi < -1)) {
+		safe = 1;
+		*deps = y.deps;
+	}
+
+	if (op == TOK_PLUS || op == TOK_MINUS) {
+		combine(a, op, b);
+		if (a->kind != SHAPE_OTHER)
+			return safe;
+	}
+	if (ranged)
+		*a = x;
 	else
-		aout(L"(void) fprintf(stdout, \"%%ld\", (long) %s);", token);
+		a->kind = SHAPE_OTHER;
+	return safe;
 }
 
-static void
-cg_init(void)
+/*
+ * Checked arithmetic.
+ *
+ * With -C every +, -, * and / traps on overflow, and / on division by
+ * 0, unless the ranges of its operands rule that out.  An operator is a
+ * site like a subscript, decided when the loops its ranges come from
+ * end.  Each expression and term with operators opens a slot first, as
+ * the checks nest around its left operand.
+ */
+
+static long
+arithbegin(void)
 {
-	aout(L"#include <stdio.h>\n");
-	aout(L"#include <wchar.h>\n");
-	aout(L"#include <wctype.h>\n");
-	aout(L"#include <locale.h>\n\n");
-	aout(L"static char __stdin[24];\n\n");
+
+	if (!checking)
+		return -1;
+	cg_checkbegin(nslots);
+	return nslots++;
 }
 
+static size_t
+arithop(long open)
+{
+	size_t id;
+
+	if (open < 0) {
+		cg_symbol();
+		return 0;
+	}
+	id = newsite(0);
+	site(id)->arith = 1;
+	nslots++;
+	cg_checkop(site(id)->open, open);
+	return id;
+}
 
 /*
- * Parser.
+ * The right operand b of the operator at site id, on line at, has been
+ * parsed.
  */
-
 static void
-next(void)
+arithcheck(long open, size_t id, size_t at, struct shape *a, int op,
+    const struct shape *b)
 {
+	unsigned long deps;
+	int safe;
+
+	safe = fold(a, op, b, &deps);
+	if (open < 0)
+		return;
 
-	type = lex();
-	// ++raw;
+	site(id)->close = nslots++;
+	cg_checkline(site(id)->close, (long) at);
+	if (safe)
+		defer(id, deps);
+	else
+		resolve(id, 1);
 }
 
 static void
-expect(int match)
+arithend(long open, int any)
 {
 
-	if (match != type)
-		error("syntax error");
-
-	next();
+	if (open >= 0)
+		cg_checkend(open, any);
 }
 
-static void term(void);
+static void
+exprrest(long open)
+{
+	struct shape s = shape;
+	size_t id;
+	size_t at;
+	int op, any = 0, left = wide, cast = 0;
+
+	while (type == TOK_PLUS || type == TOK_MINUS) {
+		op = type;
+		at = line;
+		csetoken(op, NULL, 0);
+		id = arithop(open);
+		next();
+		castnext = cast = widen(left, &s);
+		term();
+		arithcheck(open, id, at, &s, op, &shape);
+		left = left || cast || wide;
+		any = 1;
+	}
+	shape = s;
+	wide = left;
+	arithend(open, any);
+}
 
+/*
+ * A leading - is checked as 0 - term.
+ */
 static void
 expression(void)
 {
+	long open = arithbegin();
+	int op = 0;
+
+	if (type == TOK_MINUS && open >= 0) {
+		cg_number(0);
+		shape.kind = SHAPE_CONST;
+		shape.off = 0;
+		wide = 0;
+		exprrest(open);
+		return;
+	}
 	if (type == TOK_PLUS || type == TOK_MINUS) {
+		op = type;
+		csetoken(op, NULL, 0);
 		cg_symbol();
 		next();
 	}
 	term();
-	while (type == TOK_PLUS || type == TOK_MINUS) {
+	if (op == TOK_MINUS) {
+		if (shape.kind == SHAPE_CONST)
+			shape.off = -shape.off;
+		else
+			shape.kind = SHAPE_OTHER;
+	}
+	exprrest(open);
+}
+
+static void
+subscript(struct symtab *sym, int write)
+{
+	size_t id;
+
+	if (type != TOK_LBRACK)
+		error("array needs an index: %ls", sym->name);
+
+	id = newsite(sym->size);
+	cg_index(site(id)->open);
+	expect(TOK_LBRACK);
+	expression();
+	site(id)->close = nslots++;
+	cg_endindex(site(id)->close, sym->size);
+	expect(TOK_RBRACK);
+
+	checksite(id, &shape);
+	parindex(sym, &shape, write);
+}
+
+/*
+ * A use of sym, the current token.  Constants of procedures are written
+ * out, since the procedure's C function may not be the one using them.
+ */
+static void
+reference(struct symtab *sym)
+{
+
+	if (sym->type == TOK_CONST && sym->owner != NULL)
+		cg_number(sym->value);
+	else
 		cg_symbol();
+
+	lift(curproc, sym);
+}
+
+/*
+ * Arguments of a call, with sym the current token.  Returns how many.
+ */
+static long
+arguments(struct symtab *sym, int how)
+{
+	long n = 0;
+
+	next();
+	if (type == TOK_LPAREN) {
 		next();
-		term();
+		while (type != TOK_RPAREN) {
+			if (n > 0) {
+				if (type == TOK_COMMA && how == ARGS_CALL)
+					cg_symbol();
+				expect(TOK_COMMA);
+			}
+			if (how == ARGS_TEMPS)
+				cg_temp(n);
+			else if (how == ARGS_TASK)
+				cg_taskarg();
+			expression();
+			n++;
+		}
+		expect(TOK_RPAREN);
+	}
+
+	if (n != sym->proc->nparams)
+		error("%ls takes %ld arguments, not %ld", sym->name,
+		    sym->proc->nparams, n);
+
+	return n;
+}
+
+static void
+call(struct symtab *sym)
+{
+	struct proc *p = sym->proc;
+
+	parforbid("a call");
+	cg_call(sym->id, p->num, p->memo);
+	arguments(sym, ARGS_CALL);
+	if (p->parent != NULL)
+		addcall(p, 0);
+	cg_endcall();
+
+	touchcall(p);
+	clobbered();
+}
+
+/*
+ * A समवर्ती call evaluates its arguments now and runs p as a task of the
+ * current function.
+ */
+static void
+spawn(struct symtab *sym)
+{
+	struct proc *p = sym->proc;
+	struct task *t;
+	size_t at = line;
+
+	parforbid("a call");
+	impure();
+	cg_spawn(sym->id, p->num);
+	arguments(sym, ARGS_TASK);
+	if (p->parent != NULL)
+		addcall(p, 1);
+	cg_endspawn(sym->id, p->num);
+
+	touchcall(p);
+	if (!p->spawned && p->parent == NULL)
+		addthunk(p);
+	p->spawned = 1;
+	tasking = 1;
+
+	if (ntasks == taskcap) {
+		taskcap = taskcap ? taskcap * 2 : 16;
+		if ((tasks = realloc(tasks, taskcap * sizeof(*tasks))) == NULL)
+			error("malloc failed");
 	}
+	t = &tasks[ntasks];
+	t->callee = p;
+	memset(&t->with, 0, sizeof(t->with));
+	t->line = at;
+	run(ntasks++);
+
+	clobbered();
 }
 
 static void
 factor(void)
 {
+	struct symtab *sym;
+	struct paren p;
+
 	switch (type) {
 	case TOK_IDENT:
-		symcheck(CHECK_RHS);
-		/* Fallthru */
+		sym = symcheck(CHECK_ANY);
+		shape.kind = SHAPE_OTHER;
+		if (sym->type == TOK_PROCEDURE) {
+			cseimpure++;
+			call(sym);
+			shape.kind = SHAPE_OTHER;
+			wide = 1;
+			break;
+		}
+		reference(sym);
+		touch(sym, USE_READ);
+		next();
+		wide = 1;
+		if (sym->size) {
+			cseimpure++;
+			subscript(sym, 0);
+			shape.kind = SHAPE_OTHER;
+			wide = sym->range == RANGE_NONE;
+		} else if (sym->type == TOK_CONST) {
+			csetoken(TOK_NUMBER, NULL, sym->value);
+			shape.kind = SHAPE_CONST;
+			shape.off = sym->value;
+			wide = sym->owner == NULL || sym->value < INT_MIN ||
+			    sym->value > INT_MAX;
+		} else {
+			csetoken(TOK_IDENT, sym, 0);
+			parread(sym);
+			shape.kind = SHAPE_VAR;
+			shape.sym = sym;
+			shape.off = 0;
+		}
+		break;
 	case TOK_NUMBER:
+		csetoken(TOK_NUMBER, NULL, tokval);
 		cg_symbol();
+		shape.kind = SHAPE_CONST;
+		shape.off = tokval;
+		wide = tokval < INT_MIN || tokval > INT_MAX;
 		next();
 		break;
 	case TOK_LPAREN:
 		cg_symbol();
 		expect(TOK_LPAREN);
+		csebegin(&p);
 		expression();
+		cseend(&p);
 		if (type == TOK_RPAREN)
 			cg_symbol();
 		expect(TOK_RPAREN);
+		break;
+	default:
+		shape.kind = SHAPE_OTHER;
+		wide = 1;
 	}
 }
 
 static void
-term(void)
+termrest(long open)
 {
-	factor();
+	struct shape s = shape;
+	size_t id;
+	size_t at;
+	int op, any = 0, left = wide, cast = 0;
+
 	while (type == TOK_MULTIPLY || type == TOK_DIVIDE) {
-		cg_symbol();
+		op = type;
+		at = line;
+		csetoken(op, NULL, 0);
+		id = arithop(open);
 		next();
+		cast = widen(left, &s);
 		factor();
+		arithcheck(open, id, at, &s, op, &shape);
+		left = left || cast || wide;
+		any = 1;
 	}
+	shape = s;
+	wide = left;
+	arithend(open, any);
+}
+
+static void
+term(void)
+{
+	long open = arithbegin();
+	int cast = castnext;
+
+	castnext = 0;
+	factor();
+	wide |= cast;
+	termrest(open);
 }
 
 static void
 condition(void)
 {
+	long a;
+
+	stmtfirst = nsites;
+	a = foldbegin();
+
 	if (type == TOK_ODD) {
+		condop = TOK_ODD;
 		cg_symbol();
 		expect(TOK_ODD);
 		expression();
+		cond[0] = shape;
 		cg_odd();
 	} else {
 		expression();
+		cond[0] = shape;
 
 		switch (type) {
 		case TOK_EQUAL:
 		case TOK_HASH:
 		case TOK_LESSTHAN:
 		case TOK_GREATERTHAN:
+			condop = type;
 			cg_symbol();
 			next();
-			break;
-		default:
-			error("invalid conditional");
+			break;
+		default:
+			error("invalid conditional");
+		}
+		expression();
+		cond[1] = shape;
+	}
+
+	foldend(a);
+	stmtend();
+}
+
+/*
+ * "लौटाओ p(...)" inside p.  Unless more of the expression follows, the
+ * call is a tail call and becomes a jump back to the top of p.
+ */
+static void
+selfcall(struct symtab *sym)
+{
+	struct proc *p = curproc;
+	struct symtab *v;
+	size_t i;
+	long n, k = 0, open, topen;
+
+	n = arguments(sym, ARGS_TEMPS);
+	cg_endtemps(n);
+
+	switch (type) {
+	case TOK_PLUS:
+	case TOK_MINUS:
+	case TOK_MULTIPLY:
+	case TOK_DIVIDE:
+		cg_return();
+		joinpoint(0);
+		open = arithbegin();
+		topen = arithbegin();
+		cg_call(sym->id, p->num, 0);
+		cg_usetemps(n);
+		if (p->parent != NULL)
+			addcall(p, 0);
+		cg_endcall();
+		touchcall(p);
+		clobbered();
+		shape.kind = SHAPE_OTHER;
+		wide = 1;
+		termrest(topen);
+		exprrest(open);
+		cg_endself();
+		return;
+	}
+
+	joinpoint(1);
+	for (i = 0; i < p->nown; i++) {
+		v = p->own[i];
+		if (v->param) {
+			cg_reassign(v->id, k++);
+			assigned(v, NULL);
+		}
+	}
+	cg_goto();
+	p->tail = 1;
+}
+
+/*
+ * The right-hand side of "s := s + ..." or "s := s - ...", s a reduction.
+ */
+static void
+reduction(struct symtab *sym)
+{
+	long open;
+
+	if (type != TOK_IDENT || symcheck(CHECK_ANY) != sym)
+		error("reduction variable %ls must only be added to",
+		    sym->name);
+	open = arithbegin();
+	cg_symbol();
+	wide = 1;
+	next();
+	if (type != TOK_PLUS && type != TOK_MINUS)
+		error("reduction variable %ls must only be added to",
+		    sym->name);
+	shape.kind = SHAPE_OTHER;
+	exprrest(open);
+	shape.kind = SHAPE_OTHER;
+}
+
+/*
+ * The variable of a प्रत्येक loop is read-only in its body, so that the
+ * trip count holds.
+ */
+static void
+writable(struct symtab *sym)
+{
+
+	if (sym->counting)
+		error("प्रत्येक loop variable %ls is assigned", sym->name);
+}
+
+static void
+parallel(void)
+{
+	struct par p;
+	struct symtab *sym, *v;
+	long lo = 0, hi = -1, k, divert, decl;
+	size_t i, first, at;
+	int known, role;
+
+	parforbid("a समानांतर loop");
+	at = line;
+	expect(TOK_PARALLEL);
+	if (type != TOK_IDENT)
+		error("syntax error");
+	sym = symcheck(CHECK_LHS);
+	if (sym->size)
+		error("array needs an index: %ls", sym->name);
+	writable(sym);
+	lift(curproc, sym);
+	touch(sym, USE_WRITE);
+	next();
+	expect(TOK_ASSIGN);
+
+	p.index = sym;
+	p.num = ++nparallel;
+	p.depth = 0;
+	cg_parbegin(p.num);
+	expression();
+	known = shapeval(&shape, &lo);
+	expect(TOK_TO);
+	cg_parto(p.num);
+	expression();
+	known = shapeval(&shape, &hi) && known;
+	stmtend();
+
+	for (v = head; v != NULL; v = v->next)
+		v->paruse = 0;
+	if (type == TOK_REDUCE) {
+		do {
+			next();
+			if (type != TOK_IDENT)
+				error("syntax error");
+			v = symcheck(CHECK_LHS);
+			if (v->size || v == sym)
+				error("%ls cannot be a reduction", v->name);
+			writable(v);
+			v->paruse = PAR_REDUCE;
+			lift(curproc, v);
+			next();
+		} while (type == TOK_COMMA);
+	}
+	expect(TOK_DO);
+
+	divert = nslots++;
+	cg_parbody(p.num, divert);
+	decl = slot();
+	cg_parloop(sym->id);
+
+	first = nsites;
+	pushrange(known && lo <= hi ? sym : NULL, lo, hi);
+
+	forget();
+	par = &p;
+	statement();
+	poploop();
+
+	/* Sites left to loops around this one are decided now. */
+	for (i = first > sitebase ? first : sitebase; i < nsites; i++) {
+		if (site(i)->loop >= 0)
+			resolve(i, 1);
+	}
+
+	cg_parend();
+	cg_pardecl(decl, DECL_LOCAL, sym->id);
+	for (k = 0, v = head; v != NULL; v = v->next) {
+		if ((role = parrole(v)) == 0)
+			continue;
+		rangenone(v);
+		cg_pardecl(decl, k << 3 | role, v->id);
+		if (role == DECL_ZERO)
+			cg_parreduce(k, checking ? (long) at : 0, v->id);
+		else if (role == DECL_LOCAL)
+			cg_parlast(k, v->id);
+		else
+			cg_parundef(v->id);
+		k++;
+	}
+	cg_close(decl, 1);
+	cg_enddivert(divert);
+
+	cg_parctx(p.num);
+	for (v = head; v != NULL; v = v->next) {
+		if (parrole(v) != 0)
+			cg_ctxarg(v->size == 0, v->id);
+	}
+	cg_parrun(p.num, sym->id);
+
+	for (v = head; v != NULL; v = v->next) {
+		if (v->paruse & (PAR_PRIVATE | PAR_REDUCE))
+			assigned(v, NULL);
+		v->paruse = 0;
+	}
+	assigned(sym, NULL);
+	par = NULL;
+}
+
+/*
+ * "प्रत्येक i := lo तक hi कदम s करो": s is a nonzero constant, and i takes
+ * the values lo, lo + s, ... up to hi (down to it if s is negative),
+ * holding the next one after the loop.
+ */
+static void
+counted(void)
+{
+	struct symtab *sym, *c;
+	struct shape end;
+	size_t *saved, nsaved;
+	unsigned long n = 0;
+	long lo = 0, hi = 0, step = 1, last = 0, hold, unroll = 0;
+	int known, loknown, hiknown, neg = 0;
+
+	expect(TOK_FOR);
+	if (type != TOK_IDENT)
+		error("syntax error");
+	sym = symcheck(CHECK_LHS);
+	if (sym->size)
+		error("array needs an index: %ls", sym->name);
+	writable(sym);
+	parassign(sym);
+	lift(curproc, sym);
+	touch(sym, USE_WRITE);
+	next();
+	expect(TOK_ASSIGN);
+
+	cg_forbegin();
+	expression();
+	loknown = shapeval(&shape, &lo);
+	expect(TOK_TO);
+	cg_forto();
+	expression();
+	hiknown = shapeval(&shape, &hi);
+	known = loknown && hiknown;
+	stmtend();
+
+	if (type == TOK_STEP) {
+		next();
+		if (type == TOK_MINUS) {
+			neg = 1;
+			next();
 		}
-		expression();
+		if (type == TOK_NUMBER)
+			step = tokval;
+		else if (type == TOK_IDENT &&
+		    (c = symcheck(CHECK_RHS))->type == TOK_CONST)
+			step = c->value;
+		else
+			error("step must be a number or a constant");
+		if (step == 0)
+			error("step must not be 0");
+		if (neg)
+			step = -step;
+		next();
+	}
+	expect(TOK_DO);
+
+	if (known && (step > 0 ? lo <= hi : lo >= hi)) {
+		n = (step > 0 ? (unsigned long) hi - (unsigned long) lo :
+		    (unsigned long) lo - (unsigned long) hi) /
+		    (step > 0 ? (unsigned long) step : -(unsigned long) step) + 1;
+		last = (long) ((unsigned long) lo + (n - 1) * step);
+		if (n <= FOR_UNROLL)
+			unroll = n;
+	}
+
+	/* The values it takes in the loop; the next one is assigned after. */
+	if (!known)
+		rangenone(sym);
+	else if (n > 0 && sym->range == RANGE_OPEN)
+		rangeadd(sym, step > 0 ? lo : last, step > 0 ? last : lo,
+		    n > 1 && (step & 1) ? 3 : parityof(lo));
+
+	hold = nslots++;
+	cg_forbody(sym->id, hold, step);
+	if (nfors++ == 0)
+		fortoken = stats.tokens;
+	if (n > 0)
+		pushrange(sym, step > 0 ? lo : last, step > 0 ? last : lo);
+	else if (!known && (loknown || hiknown))
+		pushrange(sym,
+		    step > 0 ? (loknown ? lo : LONG_MIN) : (hiknown ? hi : LONG_MIN),
+		    step > 0 ? (hiknown ? hi : LONG_MAX) : (loknown ? lo : LONG_MAX));
+	else
+		pushrange(NULL, 0, 0);
+
+	forget();
+	sym->counting = 1;
+	if (par != NULL)
+		par->depth++;
+	saved = saverunning(&nsaved);
+	pushtaskloop();
+	statement();
+	poptaskloop();
+	mergerunning(saved, nsaved);
+	if (par != NULL)
+		par->depth--;
+	sym->counting = 0;
+	poploop();
+
+	cg_endfor(sym->id, unroll, lo);
+	nfors--;
+
+	end.kind = SHAPE_OTHER;
+	if (known) {
+		end.kind = SHAPE_CONST;
+		end.off = (long) ((unsigned long) lo + n * step);
+		if (n > 0 && (step > 0 ? end.off < last : end.off > last))
+			end.kind = SHAPE_OTHER;
 	}
+	assigned(sym, &end);
 }
 
 static void
 statement(void)
 {
+	struct symtab *sym;
+	struct shape charshape;
+	size_t *saved, nsaved, first;
+
+	stmtfirst = nsites;
+	csecalled = 0;
+
 	switch (type) {
 	case TOK_IDENT:
-		symcheck(CHECK_LHS);
-		cg_symbol();
+		sym = symcheck(CHECK_LHS);
+		writable(sym);
+		reference(sym);
 		expect(TOK_IDENT);
+		if (sym->size)
+			subscript(sym, 1);
+		touch(sym, USE_WRITE);
 		if (type == TOK_ASSIGN)
 			cg_symbol();
 		expect(TOK_ASSIGN);
-		expression();
+		if (par != NULL && (sym->paruse & PAR_REDUCE))
+			reduction(sym);
+		else
+			expression();
+		if (!sym->size) {
+			parassign(sym);
+			assigned(sym, &shape);
+		} else
+			rangeassign(sym, &shape);
 		break;
 	case TOK_CALL:
 		expect(TOK_CALL);
-		if (type == TOK_IDENT) {
-			symcheck(CHECK_CALL);
-			cg_call();
+		if (type != TOK_IDENT)
+			error("syntax error");
+		call(symcheck(CHECK_CALL));
+		cg_semicolon();
+		break;
+	case TOK_SPAWN:
+		expect(TOK_SPAWN);
+		expect(TOK_CALL);
+		if (type != TOK_IDENT)
+			error("syntax error");
+		spawn(symcheck(CHECK_CALL));
+		break;
+	case TOK_WAIT:
+		parforbid("प्रतीक्षा");
+		impure();
+		expect(TOK_WAIT);
+		cg_wait();
+		tasking = 1;
+		nrunning = 0;
+		clobbered();
+		break;
+	case TOK_RETURN:
+		if (curproc == NULL)
+			error("लौटाओ outside a procedure");
+		parforbid("लौटाओ");
+		expect(TOK_RETURN);
+		csefirst = 0;	/* it joins tasks first */
+		if (type == TOK_IDENT &&
+		    (sym = symcheck(CHECK_ANY)) == curproc->sym) {
+			selfcall(sym);
+			break;
 		}
-		expect(TOK_IDENT);
+		cg_return();
+		joinpoint(0);
+		expression();
 		break;
 	case TOK_BEGIN:
 		cg_symbol();
 		expect(TOK_BEGIN);
-		statement();
+		first = csestmt;
+		blockstatement();
 		while (type == TOK_SEMICOLON) {
 			cg_semicolon();
 			expect(TOK_SEMICOLON);
-			statement();
+			blockstatement();
 		}
+		cseblockend(first);
 		if (type == TOK_END)
 			cg_symbol();
 		expect(TOK_END);
@@ -763,26 +7366,60 @@ statement(void)
 		if (type == TOK_THEN)
 			cg_symbol();
 		expect(TOK_THEN);
+		if (par != NULL)
+			par->depth++;
+		saved = saverunning(&nsaved);
 		statement();
+		mergerunning(saved, nsaved);
+		if (par != NULL)
+			par->depth--;
+		forget();
 		break;
 	case TOK_WHILE:
 		cg_symbol();
 		expect(TOK_WHILE);
+		csefirst = 0;	/* its condition runs every iteration */
+		enterloop();
+		if (par != NULL)
+			par->depth++;
+		saved = saverunning(&nsaved);
+		pushtaskloop();
+		first = nsites;	/* the condition is part of the back edge */
 		condition();
+		pushloop(first);
 		if (type == TOK_DO)
 			cg_symbol();
 		expect(TOK_DO);
 		statement();
+		poploop();
+		poptaskloop();
+		mergerunning(saved, nsaved);
+		if (par != NULL)
+			par->depth--;
+		break;
+	case TOK_PARALLEL:
+		parallel();
+		break;
+	case TOK_FOR:
+		counted();
 		break;
 	case TOK_WRITEINT:
+		parforbid("output");
+		impure();
 		expect(TOK_WRITEINT);
 		if (type == TOK_IDENT) {
-			if (type == TOK_IDENT)
-				symcheck(CHECK_RHS);
-			cg_writeint(1);
+			sym = symcheck(CHECK_RHS);
+			if (sym->size)
+				error("array needs an index: %ls", token);
+			if (sym->type == TOK_CONST && sym->owner != NULL)
+				cg_writeint(0, sym->value);
+			else
+				cg_writeint(1, 0);
+			lift(curproc, sym);
+			touch(sym, USE_READ);
 		}
 		else if(type == TOK_NUMBER){
-			cg_writeint(0);
+			cg_writeint(0, tokval);
 		}
 
 		if (type == TOK_IDENT)
@@ -794,14 +7431,22 @@ statement(void)
 
 		break;
 	case TOK_WRITECHAR:
+		parforbid("output");
+		impure();
 		expect(TOK_WRITECHAR);
 		if (type == TOK_IDENT) {
-			if (type == TOK_IDENT)
-				symcheck(CHECK_RHS);
-			cg_writechar(1);
+			sym = symcheck(CHECK_RHS);
+			if (sym->size)
+				error("array needs an index: %ls", token);
+			if (sym->type == TOK_CONST && sym->owner != NULL)
+				cg_writechar(0, sym->value);
+			else
+				cg_writechar(1, 0);
+			lift(curproc, sym);
+			touch(sym, USE_READ);
 		}
 		if(type == TOK_NUMBER) {
-			cg_writechar(0);
+			cg_writechar(0, tokval);
 		}
 
 		if (type == TOK_IDENT)
@@ -813,62 +7458,224 @@ statement(void)
 
 		break;
 	case TOK_READINT:
+		parforbid("input");
+		impure();
 		expect(TOK_READINT);
 		if (type == TOK_INTO)
 			expect(TOK_INTO);
 
 		if (type == TOK_IDENT) {
-			symcheck(CHECK_LHS);
+			sym = symcheck(CHECK_LHS);
+			if (sym->size)
+				error("array needs an index: %ls", token);
+			writable(sym);
 			cg_readint();
+			assigned(sym, NULL);
+			lift(curproc, sym);
+			touch(sym, USE_WRITE);
 		}
 
 		expect(TOK_IDENT);
 
 		break;
 	case TOK_READCHAR:
+		parforbid("input");
+		impure();
+		charshape.kind = SHAPE_RANGE;
+		charshape.lo = 0;
+		charshape.hi = WCHAR_MAX;
+		charshape.deps = 0;
 		expect(TOK_READCHAR);
 		if (type == TOK_INTO)
 			expect(TOK_INTO);
 
 		if (type == TOK_IDENT) {
-			symcheck(CHECK_LHS);
+			sym = symcheck(CHECK_LHS);
+			if (sym->size)
+				error("array needs an index: %ls", token);
+			writable(sym);
 			cg_readchar();
+			assigned(sym, &charshape);
+			lift(curproc, sym);
+			touch(sym, USE_WRITE);
 		}
 
 		expect(TOK_IDENT);
 	}
-	
+
+	stmtend();
+}
+
+/*
+ * Variables of main are C globals, emitted as they are declared; those
+ * of a procedure wait for its header.
+ */
+static void
+vardecl(void)
+{
+	struct symtab *sym = NULL, *size;
+
+	if (type == TOK_IDENT)
+		sym = addsymbol(TOK_VAR);
+	expect(TOK_IDENT);
+
+	if (type == TOK_LBRACK) {
+		expect(TOK_LBRACK);
+		if (type == TOK_NUMBER) {
+			sym->size = tokval;
+		} else if (type == TOK_IDENT &&
+		    (size = symcheck(CHECK_RHS))->type == TOK_CONST) {
+			sym->size = size->value;
+		} else {
+			error("array size must be a number or a constant");
+		}
+		if (sym->size <= 0)
+			error("array size must be positive: %ls", sym->name);
+		next();
+		expect(TOK_RBRACK);
+	}
+
+	if (curproc == NULL) {
+		rangeopen(sym);
+		cg_var(sym->id);
+		if (sym->size)
+			cg_dim(sym->size);
+		cg_semicolon();
+	}
+}
+
+static void
+param(void)
+{
+	struct symtab *sym;
+
+	if (type != TOK_IDENT)
+		error("syntax error");
+	sym = addsymbol(TOK_VAR);
+	sym->param = 1;
+	curproc->nparams++;
+	next();
+}
+
+/*
+ * The C function of a procedure starts where its statement does, after
+ * any procedures nested in it.
+ */
+static void
+header(struct proc *p)
+{
+	struct symtab *v;
+	size_t i;
+	long n = 0;
+
+	cg_procedure(p->sym->id, p->num);
+	for (i = 0; i < p->nown; i++) {
+		if (p->own[i]->param)
+			cg_param(p->own[i]->id, n++);
+	}
+	if (p->parent != NULL)
+		p->params = slot();
+	cg_endheader();
+
+	for (i = 0; i < p->nown; i++) {
+		v = p->own[i];
+		if (v->param)
+			continue;
+		rangeopen(v);
+		cg_var(v->id);
+		if (v->size)
+			cg_dim(v->size);
+		cg_semicolon();
+	}
+	p->defs = slot();
+}
+
+static void block(void);
+
+static void
+procedure(void)
+{
+	struct proc *p;
+	struct symtab *sym;
+
+	expect(TOK_PROCEDURE);
+	if (type != TOK_IDENT)
+		error("syntax error");
+	sym = addsymbol(TOK_PROCEDURE);
+	p = newproc(sym);
+	curproc = p;
+	next();
+
+	depth++;
+	if (type == TOK_LPAREN) {
+		expect(TOK_LPAREN);
+		param();
+		while (type == TOK_COMMA) {
+			expect(TOK_COMMA);
+			param();
+		}
+		expect(TOK_RPAREN);
+	}
+	depth--;
+
+	/* Before the semicolon, so that its line is the procedure's. */
+	cg_prototype(sym->id, p->num, p->nparams);
+	if (p->parent != NULL)
+		p->proto = slot();
+	cg_endproto();
+	expect(TOK_SEMICOLON);
+
+	block();
+	expect(TOK_SEMICOLON);
+
+	curproc = p->parent;
+	destroysymbols();
+	if (curproc == NULL)
+		lifttree();
 }
 
-void block(void)
+static void
+block(void)
 {
-    if (depth++ > 1)
-        error("nesting depth exceeded");
+    struct symtab *sym = NULL;
+    struct proc *p = curproc;
+
+    depth++;
 
     if (type == TOK_CONST) {
         expect(TOK_CONST);
         if (type == TOK_IDENT) {
-            addsymbol(TOK_CONST);
-            cg_const();
+            sym = addsymbol(TOK_CONST);
+            if (p == NULL)
+                cg_const();
         }
         expect(TOK_IDENT);
         expect(TOK_EQUAL);
         if (type == TOK_NUMBER) {
-            cg_symbol();
-            cg_semicolon();
+            sym->value = tokval;
+            sym->known = 1;
+            if (p == NULL) {
+                cg_symbol();
+                cg_semicolon();
+            }
         }
         expect(TOK_NUMBER);
         while (type == TOK_COMMA) {
             expect(TOK_COMMA);
             if (type == TOK_IDENT) {
-                addsymbol(TOK_CONST);
-                cg_const();
+                sym = addsymbol(TOK_CONST);
+                if (p == NULL)
+                    cg_const();
             }
             expect(TOK_IDENT);
             expect(TOK_EQUAL);
             if (type == TOK_NUMBER) {
-                cg_symbol();
-                cg_semicolon();
+                sym->value = tokval;
+                sym->known = 1;
+                if (p == NULL) {
+                    cg_symbol();
+                    cg_semicolon();
+                }
             }
             expect(TOK_NUMBER);
         }
@@ -877,52 +7684,37 @@ void block(void)
 
     if (type == TOK_VAR) {
         expect(TOK_VAR);
-        if (type == TOK_IDENT) {
-            addsymbol(TOK_VAR);
-            cg_var();
-        }
-        expect(TOK_IDENT);
+        vardecl();
         while (type == TOK_COMMA) {
             expect(TOK_COMMA);
-            if (type == TOK_IDENT) {
-                addsymbol(TOK_VAR);
-                cg_var();
-            }
-            expect(TOK_IDENT);
+            vardecl();
         }
         expect(TOK_SEMICOLON);
-        cg_crlf();
+        if (p == NULL)
+            cg_crlf();
     }
 
-    while (type == TOK_PROCEDURE) {
-        proc = 1;
-
-        expect(TOK_PROCEDURE);
-        if (type == TOK_IDENT) {
-            addsymbol(TOK_PROCEDURE);
-            cg_procedure();             
-        }
-        expect(TOK_IDENT);
-        expect(TOK_SEMICOLON);
-
-        block();                        
-        expect(TOK_SEMICOLON);
-
-        cg_epilogue();                  
-
-        proc = 0;
-        destroysymbols();
-    }
+    while (type == TOK_PROCEDURE)
+        procedure();
 
-    if (proc == 0) {
-        cg_procedure();                
+    if (p == NULL) {
+        cg_main();
+        taskgroup = -1;
+    } else {
+        header(p);
+        taskgroup = p->defs;
     }
 
+    forget();
     statement();
 
-    if (proc == 0) {
-        cg_epilogue();                  
-    }
+    endtasks();
+    if (p == NULL)
+        checktasks();
+    if (p != NULL && p->parent != NULL)
+        p->undefs = slot();
+    cg_crlf();
+    cg_outlined();
 
     if (--depth < 0)
         error("nesting depth fell below 0");
@@ -930,7 +7722,7 @@ void block(void)
 
 static void 
 parse(void) {
-	cg_init();    
+	cg_init(checking);
     next();
     block();
     expect(TOK_DOT);
@@ -939,32 +7731,550 @@ parse(void) {
         error("extra tokens at end of file");
     }
 
+	rangedecide(1);
+
+	emitthunks();
 	cg_end();
 }
 
+/*
+ * Code generation from IR.
+ */
+
+static void
+irreplay(void)
+{
+	struct tokrec t;
+	long arg, arg2;
+	int op;
+
+	while (inp < inend) {
+		op = *inp++;
+		arg = get_varint();
+		arg2 = get_varint();
+		line = get_varint();
+		get_token(&t);
+
+		type = t.type;
+		if (type == TOK_IDENT)
+			tokid = t.u.id;
+		else if (type == TOK_NUMBER)
+			tokval = t.u.value;
+
+		switch (op) {
+		case CG_INIT:
+			cg_init(arg);
+			break;
+		case CG_END:
+			cg_end();
+			break;
+		case CG_CONST:
+			cg_const();
+			break;
+		case CG_SEMICOLON:
+			cg_semicolon();
+			break;
+		case CG_SYMBOL:
+			cg_symbol();
+			break;
+		case CG_CRLF:
+			cg_crlf();
+			break;
+		case CG_VAR:
+			cg_var(tokid);
+			break;
+		case CG_DIM:
+			cg_dim(arg);
+			break;
+		case CG_NUMBER:
+			cg_number(arg);
+			break;
+		case CG_MAIN:
+			cg_main();
+			break;
+		case CG_PROTOTYPE:
+			cg_prototype(tokid, arg, arg2);
+			break;
+		case CG_ENDPROTO:
+			cg_endproto();
+			break;
+		case CG_PROCEDURE:
+			cg_procedure(tokid, arg);
+			break;
+		case CG_PARAM:
+			cg_param(tokid, arg);
+			break;
+		case CG_ENDHEADER:
+			cg_endheader();
+			break;
+		case CG_EPILOGUE:
+			cg_epilogue(arg);
+			break;
+		case CG_READCHAR:
+			cg_readchar();
+			break;
+		case CG_CALL:
+			cg_call(tokid, arg, arg2);
+			break;
+		case CG_ENDCALL:
+			cg_endcall();
+			break;
+		case CG_ODD:
+			cg_odd();
+			break;
+		case CG_WRITECHAR:
+			cg_writechar(arg, arg2);
+			break;
+		case CG_READINT:
+			cg_readint();
+			break;
+		case CG_WRITEINT:
+			cg_writeint(arg, arg2);
+			break;
+		case CG_INDEX:
+			cg_index(arg);
+			break;
+		case CG_ENDINDEX:
+			cg_endindex(arg, arg2);
+			break;
+		case CG_SLOT:
+			cg_slot(arg);
+			break;
+		case CG_CLOSE:
+			cg_close(arg, arg2);
+			break;
+		case CG_LIFT:
+			cg_lift(arg, arg2, tokid);
+			break;
+		case CG_TAIL:
+			cg_tail(arg);
+			break;
+		case CG_RETURN:
+			cg_return();
+			break;
+		case CG_TEMP:
+			cg_temp(arg);
+			break;
+		case CG_ENDTEMPS:
+			cg_endtemps(arg);
+			break;
+		case CG_REASSIGN:
+			cg_reassign(tokid, arg);
+			break;
+		case CG_GOTO:
+			cg_goto();
+			break;
+		case CG_USETEMPS:
+			cg_usetemps(arg);
+			break;
+		case CG_ENDSELF:
+			cg_endself();
+			break;
+		case CG_PARBEGIN:
+			cg_parbegin(arg);
+			break;
+		case CG_PARTO:
+			cg_parto(arg);
+			break;
+		case CG_PARBODY:
+			cg_parbody(arg, arg2);
+			break;
+		case CG_PARLOOP:
+			cg_parloop(tokid);
+			break;
+		case CG_PAREND:
+			cg_parend();
+			break;
+		case CG_PARDECL:
+			cg_pardecl(arg, arg2, tokid);
+			break;
+		case CG_PARREDUCE:
+			cg_parreduce(arg, arg2, tokid);
+			break;
+		case CG_PARLAST:
+			cg_parlast(arg, tokid);
+			break;
+		case CG_PARUNDEF:
+			cg_parundef(tokid);
+			break;
+		case CG_ENDDIVERT:
+			cg_enddivert(arg);
+			break;
+		case CG_PARCTX:
+			cg_parctx(arg);
+			break;
+		case CG_CTXARG:
+			cg_ctxarg(arg, tokid);
+			break;
+		case CG_PARRUN:
+			cg_parrun(arg, tokid);
+			break;
+		case CG_OUTLINED:
+			cg_outlined();
+			break;
+		case CG_SPAWN:
+			cg_spawn(tokid, arg);
+			break;
+		case CG_TASKARG:
+			cg_taskarg();
+			break;
+		case CG_ENDSPAWN:
+			cg_endspawn(tokid, arg);
+			break;
+		case CG_WAIT:
+			cg_wait();
+			break;
+		case CG_JOIN:
+			cg_join(arg, arg2);
+			break;
+		case CG_GROUP:
+			cg_group(arg);
+			break;
+		case CG_TASKS:
+			cg_tasks();
+			break;
+		case CG_THUNK:
+			cg_thunk(tokid, arg, arg2);
+			break;
+		case CG_ENDTHUNK:
+			cg_endthunk(arg, arg2);
+			break;
+		case CG_FORBEGIN:
+			cg_forbegin();
+			break;
+		case CG_FORTO:
+			cg_forto();
+			break;
+		case CG_FORBODY:
+			cg_forbody(tokid, arg, arg2);
+			break;
+		case CG_ENDFOR:
+			cg_endfor(tokid, arg, arg2);
+			break;
+		case CG_FORKEEP:
+			cg_forkeep();
+			break;
+		case CG_CHECKBEGIN:
+			cg_checkbegin(arg);
+			break;
+		case CG_CHECKOP:
+			cg_checkop(arg, arg2);
+			break;
+		case CG_CHECKLINE:
+			cg_checkline(arg, arg2);
+			break;
+		case CG_CHECKEND:
+			cg_checkend(arg, arg2);
+			break;
+		case CG_CSECOPY:
+			cg_csecopy(arg, arg2);
+			break;
+		case CG_CSEHOIST:
+			cg_csehoist(arg, arg2);
+			break;
+		case CG_CSEUSE:
+			cg_cseuse(arg, arg2);
+			break;
+		case CG_CSETEMP:
+			cg_csetemp(arg, arg2);
+			break;
+		case CG_TYPE:
+			cg_type(arg, arg2);
+			break;
+		case CG_CAST:
+			cg_cast();
+			break;
+		case CG_CONDEND:
+			cg_condend(arg, arg2);
+			break;
+		case CG_FOLD:
+			cg_fold(arg, arg2);
+			break;
+		case CG_MEMO:
+			cg_memo(tokid, arg);
+			break;
+		case CG_MEMOVAR:
+			cg_memovar(tokid, arg);
+			break;
+		default:
+			error("unknown IR operation: %d", op);
+		}
+	}
+}
+
+/*
+ * Profile feedback (--profile-use).
+ */
+
+static wchar_t *
+profname(const char *s)
+{
+	wchar_t *w;
+	size_t n;
+
+	if ((n = mbstowcs(NULL, s, 0)) == (size_t) -1)
+		error("invalid multibyte sequence");
+	if ((w = malloc((n + 1) * sizeof(*w))) == NULL)
+		error("malloc failed");
+	(void) mbstowcs(w, s, n + 1);
+	return w;
+}
+
+static int
+profcmp(const void *a, const void *b)
+{
+	const struct profsite *x = a, *y = b;
+
+	if (x->proc != y->proc)
+		return x->proc < y->proc ? -1 : 1;
+	return x->off < y->off ? -1 : x->off > y->off;
+}
+
+/*
+ * Read a profile written by a program compiled with -p.  Each site then
+ * belongs to the nearest procedure of its name at or above it.
+ */
+static void
+profread(const char *path)
+{
+	struct profproc *p;
+	struct profsite *s;
+	wchar_t **names = NULL;
+	char buf[8192], kind[8], at[8], pct[32], a[4096], b[4096];
+	size_t i, j, proccap = 0, sitecap = 0;
+	unsigned long count;
+	long ln;
+	FILE *f;
+	int n, header = 0;
+
+	if ((f = fopen(path, "r")) == NULL)
+		error("couldn't open %s", path);
+	while (fgets(buf, sizeof(buf), f) != NULL) {
+		if (buf[0] == '#') {
+			if (!strncmp(buf, "# kind", 6) && strstr(buf, " at ") != NULL)
+				header = 1;
+			continue;
+		}
+		n = sscanf(buf, "%7s %ld %7s %lu %31s %*s %4095s %4095s", kind,
+		    &ln, at, &count, pct, a, b);
+		if (!header || n < 6 ||
+		    ((!strcmp(kind, "call") || !strcmp(kind, "task")) && n < 7))
+			error("%s: not a profile", path);
+		if (!strcmp(kind, "proc")) {
+			if (nprofprocs == proccap) {
+				proccap = proccap ? proccap * 2 : 64;
+				profprocs = realloc(profprocs,
+				    proccap * sizeof(*profprocs));
+				if (profprocs == NULL)
+					error("malloc failed");
+			}
+			p = &profprocs[nprofprocs++];
+			p->name = profname(a);
+			p->line = ln;
+			p->calls = count;
+			p->total = strtod(pct, NULL);
+			continue;
+		}
+		if (nprofsites == sitecap) {
+			sitecap = sitecap ? sitecap * 2 : 64;
+			profsites = realloc(profsites,
+			    sitecap * sizeof(*profsites));
+			names = realloc(names, sitecap * sizeof(*names));
+			if (profsites == NULL || names == NULL)
+				error("malloc failed");
+		}
+		s = &profsites[nprofsites];
+		if (!strcmp(kind, "loop"))
+			s->kind = 'l';
+		else if (!strcmp(kind, "call"))
+			s->kind = 'c';
+		else if (!strcmp(kind, "task"))
+			s->kind = 't';
+		else if (!strcmp(kind, "cond"))
+			s->kind = 'i';
+		else
+			continue;
+		s->off = ln;
+		s->at = strtol(at, NULL, 10);
+		s->count = count;
+		s->taken = strtod(pct, NULL);
+		s->callee = s->kind == 'c' || s->kind == 't' ?
+		    profname(b) : NULL;
+		names[nprofsites++] = profname(a);
+	}
+	(void) fclose(f);
+
+	for (i = 0; i < nprofsites; i++) {
+		s = &profsites[i];
+		s->proc = -1;
+		for (j = 0; j < nprofprocs; j++) {
+			p = &profprocs[j];
+			if (p->line <= s->off && !wcscmp(p->name, names[i]) &&
+			    (s->proc == -1 || p->line > profprocs[s->proc].line))
+				s->proc = j;
+		}
+		if (s->proc != -1)
+			s->off -= profprocs[s->proc].line;
+		free(names[i]);
+	}
+	free(names);
+	qsort(profsites, nprofsites, sizeof(*profsites), profcmp);
+	profusing = 1;
+}
+
 /*
  * Main.
  */
 
+static void
+usage(void)
+{
+
+	(void) fputs("[INFO] Usage: hindipl0c [-CPp] [-t | -i] "
+	    "[--time-report[=json]] [--profile-use file] [--freestanding]\n"
+	    "\t[--stats] [--memo] file.hindi | - | file.tok | file.ir\n", stderr);
+	exit(1);
+}
+
 int
 main(int argc, char *argv[])
 {
 	setlocale(LC_ALL, "en_US.UTF-8");
+	scan_init();
 	map = create_hashmap(1000);
-    wchar_t *startp;
+	pthread_t lexer;
+	static const struct option longopts[] = {
+		{ "time-report", optional_argument, NULL, 'R' },
+		{ "profile-use", required_argument, NULL, 'U' },
+		{ "freestanding", no_argument, NULL, 'F' },
+		{ "stats", no_argument, NULL, 'S' },
+		{ "memo", no_argument, NULL, 'M' },
+		{ NULL, 0, NULL, 0 }
+	};
+	char *suffix, *profile = NULL;
+	int ch, pflag = 0, stage = 0, json = 0;
+
+	while ((ch = getopt_long(argc, argv, "CPitp", longopts, NULL)) != -1) {
+		switch (ch) {
+		case 'R':
+			if (optarg != NULL && strcmp(optarg, "json") != 0)
+				usage();
+			json = optarg != NULL;
+			starttiming();
+			break;
+		case 'U':
+			profile = optarg;
+			break;
+		case 'F':
+			freestanding = 1;
+			break;
+		case 'S':
+			reporting = 1;
+			break;
+		case 'M':
+			memoizing = 1;
+			break;
+		case 'C':
+			checking = 1;
+			break;
+		case 'P':
+			pflag = 1;
+			break;
+		case 'p':
+			profiling = 1;
+			break;
+		case 'i':
+		case 't':
+			stage = ch;
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (argc != 1)
+		usage();
+	if (profiling && stage != 0)
+		error("-p instruments C output, not -%c", stage);
+	if (freestanding && stage != 0)
+		error("--freestanding changes C output, not -%c", stage);
+	if (freestanding && profiling)
+		error("-p needs the C library, not --freestanding");
+	if (freestanding && memoizing)
+		error("--memo needs the C library, not --freestanding");
+	if (memoizing && stage == 't')
+		error("--memo changes the parser's output, not -t");
+	if (reporting && stage == 't')
+		error("--stats reports on the parser, not -t");
+	if (profile != NULL) {
+		if (stage != 0)
+			error("--profile-use shapes C output, not -%c", stage);
+		profread(profile);
+	}
+
+	suffix = strrchr(argv[0], '.');
+	if (suffix != NULL && !strcmp(suffix, ".ir")) {
+		if (stage != 0 || checking || reporting || memoizing)
+			error("%s is already past that stage", argv[0]);
+		interin(argv[0], KIND_IR);
+		irreplay();
+		interfree();
+		timereport(argv[0], json);
+		free_hashmap(map);
+		return 0;
+	}
 
-	if (argc != 2) {
-		(void) fputs("[INFO] Usage: hindipl0c file.hindi\n", stderr);
-		exit(1);
+	if (suffix != NULL && !strcmp(suffix, ".tok")) {
+		if (stage == 't')
+			error("%s is already past that stage", argv[0]);
+		interin(argv[0], KIND_TOKENS);
+		irout = stage == 'i';
+		parse();
+		if (irout) {
+			ch = enter(PH_EMIT);
+			interout(KIND_IR);
+			enter(ch);
+		}
+		interfree();
+		optreport(argv[0]);
+		timereport(argv[0], json);
+		free_hashmap(map);
+		return 0;
+	}
+
+	readin(argv[0]);
+
+	if (stage == 't') {
+		tokout();
+		free(window);
+		timereport(argv[0], json);
+		free_hashmap(map);
+		return 0;
 	}
+	irout = stage == 'i';
 
-	readin(argv[1]);
-	startp = raw;
+	if (pflag && (srcsize == -1 || srcsize >= PIPE_MIN)) {
+		pipelined = 1;
+		if (pthread_create(&lexer, NULL, lexthread, NULL) != 0)
+			error("couldn't start lexer thread");
+	}
 
 	parse();
 
-	free(startp);
-	free(token);
+	if (pipelined)
+		(void) pthread_join(lexer, NULL);
+
+	if (irout) {
+		ch = enter(PH_EMIT);
+		interout(KIND_IR);
+		enter(ch);
+	}
+
+	free(window);
+	optreport(argv[0]);
+	timereport(argv[0], json);
 	free_hashmap(map);
 	return 0;
 }
@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include "scan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && \
+    __WCHAR_MAX__ > 0xffff
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Scanners for the lexer's hot loops.
+ *
+ * scan_space() skips blanks, tabs and newlines; scan_comment() stops at
+ * the closing '}' or the terminating L'\0'.  Both add the newlines they
+ * pass to *nl.  scan_ident() skips the run of characters that are
+ * certainly part of an identifier (ASCII letters, digits, '_' and
+ * Devanagari U+0905..U+094F); the lexer's scalar loop finishes the rest,
+ * so the accepted set only ever has to be a subset of what ident()
+ * accepts.
+ *
+ * The x86 versions test 4 (SSE2) or 8 (AVX2) characters per step and
+ * may read up to SCAN_PAD characters past the terminator.
+ */
+
+const wchar_t *(*scan_space)(const wchar_t *, size_t *);
+const wchar_t *(*scan_comment)(const wchar_t *, size_t *);
+const wchar_t *(*scan_ident)(const wchar_t *);
+
+#define IS_IDENT(c)							\
+	(((c) >= L'a' && (c) <= L'z') || ((c) >= L'A' && (c) <= L'Z') ||	\
+	 ((c) >= L'0' && (c) <= L'9') || (c) == L'_' ||			\
+	 ((c) >= 0x0905 && (c) <= 0x094F))
+
+static const wchar_t *
+space_scalar(const wchar_t *p, size_t *nl)
+{
+
+	while (*p == L' ' || *p == L'\t' || *p == L'\n') {
+		if (*p++ == L'\n')
+			++*nl;
+	}
+
+	return p;
+}
+
+static const wchar_t *
+comment_scalar(const wchar_t *p, size_t *nl)
+{
+
+	while (*p != L'}' && *p != L'\0') {
+		if (*p++ == L'\n')
+			++*nl;
+	}
+
+	return p;
+}
+
+static const wchar_t *
+ident_scalar(const wchar_t *p)
+{
+
+	while (IS_IDENT(*p))
+		p++;
+
+	return p;
+}
+
+#ifdef SCAN_X86
+
+__attribute__((target("sse2")))
+static const wchar_t *
+space_sse2(const wchar_t *p, size_t *nl)
+{
+	const __m128i sp = _mm_set1_epi32(L' ');
+	const __m128i tab = _mm_set1_epi32(L'\t');
+	const __m128i lf = _mm_set1_epi32(L'\n');
+	__m128i v, n;
+	unsigned int stop, nlm;
+
+	for (;;) {
+		v = _mm_loadu_si128((const __m128i *) p);
+		n = _mm_cmpeq_epi32(v, lf);
+		v = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(v, sp),
+		    _mm_cmpeq_epi32(v, tab)), n);
+		stop = ~_mm_movemask_ps(_mm_castsi128_ps(v)) & 0xf;
+		nlm = _mm_movemask_ps(_mm_castsi128_ps(n));
+		if (stop != 0) {
+			nlm &= (1u << __builtin_ctz(stop)) - 1;
+			*nl += __builtin_popcount(nlm);
+			return p + __builtin_ctz(stop);
+		}
+		*nl += __builtin_popcount(nlm);
+		p += 4;
+	}
+}
+
+__attribute__((target("sse2")))
+static const wchar_t *
+comment_sse2(const wchar_t *p, size_t *nl)
+{
+	const __m128i close = _mm_set1_epi32(L'}');
+	const __m128i nul = _mm_setzero_si128();
+	const __m128i lf = _mm_set1_epi32(L'\n');
+	__m128i v;
+	unsigned int stop, nlm;
+
+	for (;;) {
+		v = _mm_loadu_si128((const __m128i *) p);
+		stop = _mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(
+		    _mm_cmpeq_epi32(v, close), _mm_cmpeq_epi32(v, nul))));
+		nlm = _mm_movemask_ps(_mm_castsi128_ps(
+		    _mm_cmpeq_epi32(v, lf)));
+		if (stop != 0) {
+			nlm &= (1u << __builtin_ctz(stop)) - 1;
+			*nl += __builtin_popcount(nlm);
+			return p + __builtin_ctz(stop);
+		}
+		*nl += __builtin_popcount(nlm);
+		p += 4;
+	}
+}
+
+/* lo <= v <= hi, for non-negative bounds. */
+#define RANGE128(v, lo, hi)						\
+	_mm_and_si128(_mm_cmpgt_epi32((v), _mm_set1_epi32((lo) - 1)),	\
+	    _mm_cmpgt_epi32(_mm_set1_epi32((hi) + 1), (v)))
+
+__attribute__((target("sse2")))
+static const wchar_t *
+ident_sse2(const wchar_t *p)
+{
+	__m128i v, lower, ok;
+	unsigned int stop;
+
+	for (;;) {
+		v = _mm_loadu_si128((const __m128i *) p);
+		/* Fold ASCII case: 'A'..'Z' | 0x20 == 'a'..'z'. */
+		lower = _mm_or_si128(v, _mm_set1_epi32(0x20));
+		ok = _mm_or_si128(RANGE128(lower, L'a', L'z'),
+		    RANGE128(v, L'0', L'9'));
+		ok = _mm_or_si128(ok, _mm_cmpeq_epi32(v, _mm_set1_epi32(L'_')));
+		ok = _mm_or_si128(ok, RANGE128(v, 0x0905, 0x094F));
+		stop = ~_mm_movemask_ps(_mm_castsi128_ps(ok)) & 0xf;
+		if (stop != 0)
+			return p + __builtin_ctz(stop);
+		p += 4;
+	}
+}
+
+__attribute__((target("avx2")))
+static const wchar_t *
+space_avx2(const wchar_t *p, size_t *nl)
+{
+	const __m256i sp = _mm256_set1_epi32(L' ');
+	const __m256i tab = _mm256_set1_epi32(L'\t');
+	const __m256i lf = _mm256_set1_epi32(L'\n');
+	__m256i v, n;
+	unsigned int stop, nlm;
+
+	for (;;) {
+		v = _mm256_loadu_si256((const __m256i *) p);
+		n = _mm256_cmpeq_epi32(v, lf);
+		v = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(v, sp),
+		    _mm256_cmpeq_epi32(v, tab)), n);
+		stop = ~_mm256_movemask_ps(_mm256_castsi256_ps(v)) & 0xff;
+		nlm = _mm256_movemask_ps(_mm256_castsi256_ps(n));
+		if (stop != 0) {
+			nlm &= (1u << __builtin_ctz(stop)) - 1;
+			*nl += __builtin_popcount(nlm);
+			return p + __builtin_ctz(stop);
+		}
+		*nl += __builtin_popcount(nlm);
+		p += 8;
+	}
+}
+
+__attribute__((target("avx2")))
+static const wchar_t *
+comment_avx2(const wchar_t *p, size_t *nl)
+{
+	const __m256i close = _mm256_set1_epi32(L'}');
+	const __m256i nul = _mm256_setzero_si256();
+	const __m256i lf = _mm256_set1_epi32(L'\n');
+	__m256i v;
+	unsigned int stop, nlm;
+
+	for (;;) {
+		v = _mm256_loadu_si256((const __m256i *) p);
+		stop = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(
+		    _mm256_cmpeq_epi32(v, close), _mm256_cmpeq_epi32(v, nul))));
+		nlm = _mm256_movemask_ps(_mm256_castsi256_ps(
+		    _mm256_cmpeq_epi32(v, lf)));
+		if (stop != 0) {
+			nlm &= (1u << __builtin_ctz(stop)) - 1;
+			*nl += __builtin_popcount(nlm);
+			return p + __builtin_ctz(stop);
+		}
+		*nl += __builtin_popcount(nlm);
+		p += 8;
+	}
+}
+
+#define RANGE256(v, lo, hi)						\
+	_mm256_and_si256(_mm256_cmpgt_epi32((v),			\
+	    _mm256_set1_epi32((lo) - 1)),				\
+	    _mm256_cmpgt_epi32(_mm256_set1_epi32((hi) + 1), (v)))
+
+__attribute__((target("avx2")))
+static const wchar_t *
+ident_avx2(const wchar_t *p)
+{
+	__m256i v, lower, ok;
+	unsigned int stop;
+
+	for (;;) {
+		v = _mm256_loadu_si256((const __m256i *) p);
+		lower = _mm256_or_si256(v, _mm256_set1_epi32(0x20));
+		ok = _mm256_or_si256(RANGE256(lower, L'a', L'z'),
+		    RANGE256(v, L'0', L'9'));
+		ok = _mm256_or_si256(ok,
+		    _mm256_cmpeq_epi32(v, _mm256_set1_epi32(L'_')));
+		ok = _mm256_or_si256(ok, RANGE256(v, 0x0905, 0x094F));
+		stop = ~_mm256_movemask_ps(_mm256_castsi256_ps(ok)) & 0xff;
+		if (stop != 0)
+			return p + __builtin_ctz(stop);
+		p += 8;
+	}
+}
+
+#endif /* SCAN_X86 */
+
+/*
+ * Pick the widest implementation the CPU supports.  HINDIPL0_SCAN may
+ * name a narrower one ("scalar", "sse2", "avx2") for benchmarking.
+ */
+void
+scan_init(void)
+{
+	const char *want = getenv("HINDIPL0_SCAN");
+
+	scan_space = space_scalar;
+	scan_comment = comment_scalar;
+	scan_ident = ident_scalar;
+
+	if (want != NULL && !strcmp(want, "scalar"))
+		return;
+
+#ifdef SCAN_X86
+	__builtin_cpu_init();
+
+#ifndef __x86_64__
+	if (!__builtin_cpu_supports("sse2"))
+		return;
+#endif
+	scan_space = space_sse2;
+	scan_comment = comment_sse2;
+	scan_ident = ident_sse2;
+
+	if (want != NULL && !strcmp(want, "sse2"))
+		return;
+
+	if (__builtin_cpu_supports("avx2")) {
+		scan_space = space_avx2;
+		scan_comment = comment_avx2;
+		scan_ident = ident_avx2;
+	}
+#endif
+}
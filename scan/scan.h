@@ -0,0 +1,19 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+#include <wchar.h>
+
+/*
+ * Wide characters of zero padding the scanners may read past the
+ * terminating L'\0' of a buffer.
+ */
+#define SCAN_PAD 8
+
+void scan_init(void);
+
+extern const wchar_t *(*scan_space)(const wchar_t *p, size_t *nl);
+extern const wchar_t *(*scan_comment)(const wchar_t *p, size_t *nl);
+extern const wchar_t *(*scan_ident)(const wchar_t *p);
+
+#endif
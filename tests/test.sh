@@ -23,6 +23,115 @@ for i in *.hindi; do
         continue
     fi
 
+    # The source streamed from a pipe must compile the same.
+    if ! cat "$i" | ./../hindipl0c - | cmp -s - "$c_file"; then
+        echo "fail (stdin)"
+        continue
+    fi
+
+    # The staged pipeline must reproduce the single-pass output.
+    tok_file="output/${base_name}.tok"
+    ir_file="output/${base_name}.ir"
+    if ! ./../hindipl0c -t "$i" > "$tok_file" ||
+       ! ./../hindipl0c -i "$tok_file" > "$ir_file" ||
+       ! ./../hindipl0c "$ir_file" | cmp -s - "$c_file"; then
+        echo "fail (stages)"
+        continue
+    fi
+
+    # So must the checked (-C) build.
+    checked_file="output/${base_name}-C.c"
+    if ! ./../hindipl0c -C "$i" > "$checked_file" 2>&1 ||
+       ! ./../hindipl0c -C -i "$tok_file" > "$ir_file" ||
+       ! ./../hindipl0c "$ir_file" | cmp -s - "$checked_file"; then
+        echo "fail (checked)"
+        continue
+    fi
+
+    # And the profiled (-p) build, which only the code generator sees.
+    profiled_file="output/${base_name}-p.c"
+    if ! ./../hindipl0c -p "$i" > "$profiled_file" 2>&1 ||
+       ! ./../hindipl0c -i "$tok_file" > "$ir_file" ||
+       ! ./../hindipl0c -p "$ir_file" | cmp -s - "$profiled_file"; then
+        echo "fail (profiled)"
+        continue
+    fi
+
+    # And the freestanding build, whose runtime replaces the C library.
+    free_file="output/${base_name}-free.c"
+    if ! ./../hindipl0c --freestanding "$i" > "$free_file" 2>&1 ||
+       ! ./../hindipl0c --freestanding "$ir_file" | cmp -s - "$free_file"; then
+        echo "fail (freestanding)"
+        continue
+    fi
+
+    # And the build shaped by a profile, where the test comes with one.
+    prof="${base_name}.prof"
+    fed_file="output/${base_name}-fed.c"
+    if [ -f "$prof" ] &&
+       { ! ./../hindipl0c --profile-use "$prof" "$i" > "$fed_file" 2>&1 ||
+         ! ./../hindipl0c --profile-use "$prof" "$ir_file" |
+           cmp -s - "$fed_file"; }; then
+        echo "fail (profile-use)"
+        continue
+    fi
+
+    # And the memoized (--memo) build, which the parser decides on.
+    memo_file="output/${base_name}-memo.c"
+    if ! ./../hindipl0c --memo "$i" > "$memo_file" 2>&1 ||
+       ! ./../hindipl0c --memo -i "$tok_file" > "$ir_file" ||
+       ! ./../hindipl0c "$ir_file" | cmp -s - "$memo_file"; then
+        echo "fail (memo)"
+        continue
+    fi
+
+    # A test that comes with its output must print it, on one thread and
+    # with its समानांतर loops split over four.
+    out_file="${base_name}.out"
+    run_file="output/${base_name}-run"
+    if [ -f "$out_file" ] &&
+       { ! gcc -w -pthread "$c_file" -o "$run_file" ||
+         ! HINDIPL0_THREADS=1 timeout 10 "./$run_file" < /dev/null |
+           cmp -s - "$out_file" ||
+         ! HINDIPL0_THREADS=4 timeout 10 "./$run_file" < /dev/null |
+           cmp -s - "$out_file"; }; then
+        echo "fail (output)"
+        continue
+    fi
+
+    # The memoized build must print the same, hits replaying the globals
+    # a call wrote.
+    if [ -f "$out_file" ] &&
+       { ! gcc -w -pthread "$memo_file" -o "$run_file" ||
+         ! timeout 10 "./$run_file" < /dev/null 2> /dev/null |
+           cmp -s - "$out_file"; }; then
+        echo "fail (memo output)"
+        continue
+    fi
+
+    # A test that must trap comes with the message it traps with.
+    trap_file="${base_name}.trap"
+    if [ -f "$trap_file" ] &&
+       { ! gcc -w -pthread "$c_file" -o "output/${base_name}-trap" ||
+         ! timeout 10 "./output/${base_name}-trap" 2>&1 >/dev/null |
+           cmp -s - "$trap_file"; }; then
+        echo "fail (trap)"
+        continue
+    fi
+
+    # And -C.trap the message its checked build traps with, optimized so
+    # that an unchecked overflow would be undefined rather than wrap.  Two
+    # threads, one block each, split any समानांतर loop the same everywhere.
+    trap_file="${base_name}-C.trap"
+    if [ -f "$trap_file" ] &&
+       { ! gcc -w -O1 -pthread "$checked_file" -o "output/${base_name}-C-trap" ||
+         ! HINDIPL0_THREADS=2 HINDIPL0_SCHEDULE=static timeout 10 \
+             "./output/${base_name}-C-trap" 2>&1 >/dev/null |
+           cmp -s - "$trap_file"; }; then
+        echo "fail (checked trap)"
+        continue
+    fi
+
     echo "ok"
 
     if [ "$1" == "-o" ]; then